@@ -0,0 +1,237 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+EPOCH-BASED RECLAMATION (EBR)
+-----------------------------
+Problem: a writer replaces a shared object (e.g. publishes a new table through an atomic pointer) while readers
+may still be using the old one. When is it safe to free the old one?
+
+Idea (see Keir Fraser's thesis "Practical lock-freedom", and the crossbeam-epoch / folly hazptr docs):
+  - There is a global epoch counter.
+  - A reader "pins" itself before touching shared objects: it copies the global epoch into its own slot, and
+    clears the slot when it is done (slot == 0 means quiescent).
+  - The writer unlinks the old object, advances the global epoch and retires the object tagged with the epoch
+    it had before advancing (e).
+  - A reader that can still see the object must have pinned before the unlink, hence announced an epoch <= e.
+    So once every slot is either 0 or > e, nobody can hold a reference anymore and the object can be freed.
+
+Readers only do plain loads/stores on their own cache line plus one fence: no read-modify-write on shared data,
+so they never bounce a contended cache line between cores. All the expensive work is on the writer side.
+
+The reader's fence is still a full barrier (mfence or a locked instruction on x86, ~20-30 cycles), which is about as
+much as the lookup itself. On Linux we make the fences asymmetric: readers only use a compiler barrier, and the
+writer calls membarrier(2), which makes the kernel run a full barrier on every CPU currently running one of our
+threads. Writes are rare, so paying a syscall there to make every read cheaper is a good deal (this is what
+liburcu and folly's asymmetric barriers do).
+
+Limitations of this simple version:
+  - At most MAX_THREADS threads can be registered at the same time (a thread gets a slot on its first pin()
+    and gives it back when it exits).
+  - retire()/reclaim() must be serialized by the caller (typically they are called under a writer lock).
+  - A reader that stays pinned forever prevents any reclamation.
+*/
+
+namespace pysojic
+{
+    namespace epoch_detail
+    {
+        inline constexpr size_t MAX_THREADS = 128;
+
+        inline std::atomic<bool> g_SlotUsed[MAX_THREADS];
+
+        // Process-wide registry handing a slot index to each thread for as long as it lives
+        class ThreadSlot
+        {
+        public:
+            ThreadSlot()
+            {
+                for (size_t i = 0; i < MAX_THREADS; ++i)
+                {
+                    if (!g_SlotUsed[i].load(std::memory_order_relaxed) && !g_SlotUsed[i].exchange(true, std::memory_order_acquire))
+                    {
+                        m_Index = i;
+                        return;
+                    }
+                }
+                throw std::runtime_error("EpochDomain: too many threads");
+            }
+            ~ThreadSlot() { g_SlotUsed[m_Index].store(false, std::memory_order_release); }
+
+            ThreadSlot(const ThreadSlot&) = delete;
+            ThreadSlot& operator=(const ThreadSlot&) = delete;
+
+            size_t index() const noexcept { return m_Index; }
+
+        private:
+            size_t m_Index;
+        };
+
+        inline size_t this_thread_slot()
+        {
+            thread_local ThreadSlot slot;
+            return slot.index();
+        }
+
+        inline bool has_membarrier() noexcept
+        {
+#if defined(__linux__)
+            static const bool registered = syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+            return registered;
+#else
+            return false;
+#endif
+        }
+
+        // Reader side of the fence pair
+        inline void light_fence() noexcept
+        {
+            if (has_membarrier())
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+            else
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        // Writer side of the fence pair
+        inline void heavy_fence() noexcept
+        {
+#if defined(__linux__)
+            if (has_membarrier() && syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) == 0)
+                return;
+#endif
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    class EpochDomain
+    {
+        struct alignas(64) Slot
+        {
+            std::atomic<std::uint64_t> epoch{0};
+            std::uint32_t depth = 0; // only touched by the owning thread, makes pin() reentrant
+        };
+
+        struct Retired
+        {
+            void* ptr;
+            void (*deleter)(void*);
+            std::uint64_t epoch;
+        };
+
+    public:
+        // RAII pin: shared objects loaded while the guard is alive stay valid until it is destroyed
+        class Guard
+        {
+        public:
+            explicit Guard(EpochDomain& domain) : m_Slot{domain.enter()} {}
+            ~Guard() { EpochDomain::leave(*m_Slot); }
+
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+        private:
+            Slot* m_Slot;
+        };
+
+        EpochDomain() = default;
+        ~EpochDomain();
+
+        EpochDomain(const EpochDomain&) = delete;
+        EpochDomain& operator=(const EpochDomain&) = delete;
+
+        Guard pin() { return Guard{*this}; }
+
+        // Writer side, the caller must serialize these
+        void retire(void* ptr, void (*deleter)(void*));
+        template <typename T>
+        void retire(T* ptr) { retire(ptr, [](void* p) { delete static_cast<T*>(p); }); }
+        size_t reclaim();
+        size_t pending() const noexcept { return m_Retired.size(); }
+
+    private:
+        Slot* enter();
+        static void leave(Slot& slot) noexcept;
+
+    private:
+        std::atomic<std::uint64_t> m_GlobalEpoch{1};
+        Slot m_Slots[epoch_detail::MAX_THREADS];
+        std::vector<Retired> m_Retired;
+    };
+
+    //------------ Implementation ------------
+
+    // The acquire load pairs with the writer's fetch_add in retire(): if we read the advanced epoch, we are
+    // guaranteed to also see the pointer the writer published before advancing it.
+    // The fence orders our announcement before the loads of the shared objects, and pairs with the
+    // fence in reclaim(): either the writer sees our slot, or we see the writer's new pointer.
+    inline EpochDomain::Slot* EpochDomain::enter()
+    {
+        Slot& slot = m_Slots[epoch_detail::this_thread_slot()];
+        if (slot.depth++ == 0)
+        {
+            slot.epoch.store(m_GlobalEpoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+            epoch_detail::light_fence();
+        }
+        return &slot;
+    }
+
+    inline void EpochDomain::leave(Slot& slot) noexcept
+    {
+        if (--slot.depth == 0)
+            slot.epoch.store(0, std::memory_order_release);
+    }
+
+    inline void EpochDomain::retire(void* ptr, void (*deleter)(void*))
+    {
+        std::uint64_t epoch = m_GlobalEpoch.fetch_add(1, std::memory_order_acq_rel);
+        m_Retired.push_back({ptr, deleter, epoch});
+    }
+
+    // Free every retired object tagged with an epoch older than the oldest epoch still announced by a reader
+    inline size_t EpochDomain::reclaim()
+    {
+        epoch_detail::heavy_fence();
+
+        std::uint64_t oldest = UINT64_MAX;
+        for (const Slot& slot : m_Slots)
+        {
+            std::uint64_t epoch = slot.epoch.load(std::memory_order_acquire);
+            if (epoch != 0 && epoch < oldest)
+                oldest = epoch;
+        }
+
+        size_t freed = 0;
+        for (size_t i = 0; i < m_Retired.size(); )
+        {
+            if (m_Retired[i].epoch < oldest)
+            {
+                m_Retired[i].deleter(m_Retired[i].ptr);
+                m_Retired[i] = m_Retired.back();
+                m_Retired.pop_back();
+                ++freed;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        return freed;
+    }
+
+    // No reader may be pinned anymore when the domain dies
+    inline EpochDomain::~EpochDomain()
+    {
+        for (const Retired& r : m_Retired)
+            r.deleter(r.ptr);
+    }
+}
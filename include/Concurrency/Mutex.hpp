@@ -1,9 +1,11 @@
+#pragma once
+
 #include <atomic>
 
 class Mutex
 {
 public:
-    Mutex();
+    Mutex() noexcept;
 
     void lock() noexcept;
     bool try_lock() noexcept;
@@ -13,22 +15,22 @@ private:
     std::atomic_flag m_Flag;
 };
 
-Mutex::Mutex() noexcept
+inline Mutex::Mutex() noexcept
     : m_Flag{ATOMIC_FLAG_INIT}
 {}
 
-void Mutex::lock() noexcept
+inline void Mutex::lock() noexcept
 {
     while(m_Flag.test_and_set(std::memory_order_acquire))
         m_Flag.wait(true, std::memory_order_relaxed);
 }
 
-bool Mutex::try_lock() noexcept
+inline bool Mutex::try_lock() noexcept
 {
     return !m_Flag.test_and_set(std::memory_order_acquire);
 }
 
-void Mutex::unlock()
+inline void Mutex::unlock() noexcept
 {
     m_Flag.clear(std::memory_order_release);
     m_Flag.notify_one();
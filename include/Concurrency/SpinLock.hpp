@@ -1,5 +1,9 @@
+#pragma once
+
 #include <atomic>
-#include <iostream>
+#include <thread>
+
+#include "Concurrency/WaitStrategy.hpp"
 
 /*
 NOTE ABOUT PERFORMANCE UNDER CONTENTION
@@ -55,36 +59,50 @@ current owner can reach unlock(). This is why you will often see implementations
 See Fedor Pikus' book pp 209-211. This is also mentionned in Rigtorp's blog post in note 1.
 */
 
+// lock() below is a TTAS lock with pause (improvements 1 and 2 of NOTE 1), and yields once it has waited for a
+// while (NOTE 2).
 class SpinLock
 {
 public:
-    SpinLock();
+    SpinLock() noexcept;
 
     void lock() noexcept;
     bool try_lock() noexcept;
     void unlock() noexcept;
 
 private:
+    // Paused polls before yielding: a few hundred ns, longer than the critical sections a spinlock is meant for
+    static constexpr int SPIN_COUNT = 128;
+
     std::atomic_flag m_Flag;
 };
 
-SpinLock::SpinLock()
+inline SpinLock::SpinLock() noexcept
     : m_Flag{ATOMIC_FLAG_INIT}
 {}
 
-void SpinLock::lock() noexcept
+inline void SpinLock::lock() noexcept
 {   
-    while(m_Flag.test_and_set(std::memory_order_acquire))
-        std::cout << "Already locked, keep spinning" << std::endl;
-    std::cout << "Lock acquired!" << std::endl;
+    // One RMW attempt, then wait with plain loads (the cache line stays shared between the waiters) until the lock
+    // looks free, and only then try the RMW again
+    while (m_Flag.test_and_set(std::memory_order_acquire))
+    {
+        for (int spins = 0; m_Flag.test(std::memory_order_relaxed); ++spins)
+        {
+            if (spins < SPIN_COUNT)
+                pysojic::cpu_relax();
+            else
+                std::this_thread::yield(); // the owner may be descheduled, let it run
+        }
+    }
 }
 
-bool SpinLock::try_lock() noexcept
+inline bool SpinLock::try_lock() noexcept
 {
     return !m_Flag.test_and_set(std::memory_order_acquire);
 }
 
-void SpinLock::unlock() noexcept
+inline void SpinLock::unlock() noexcept
 {
     m_Flag.clear(std::memory_order_release);
 }
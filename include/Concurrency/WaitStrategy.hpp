@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// How a thread waits for something another thread will publish (e.g. a consumer waiting for an element).
+// Each strategy has:
+//   - wait(ready): returns once ready() is true. ready() is called on the waiting thread only, as often as needed.
+//   - notify(): called by the publishing thread after every publish.
+// From lowest latency / highest CPU to highest latency / lowest CPU:
+//   - BusySpinWait: polls ready() in a tight loop. Reacts within a few ns, but burns a full core for as long as
+//     it waits (and slows down its hyper-thread sibling).
+//   - PauseSpinWait: a few tight polls, then a pause instruction between polls. Still a busy core, but it leaves
+//     the pipeline to the sibling hyper-thread and draws less power.
+//   - ParkingWait: spins and pauses for a while, then parks the thread in the kernel (futex on Linux, through
+//     std::atomic::wait) until notify(). No CPU at all while idle, but waking up costs a few microseconds.
+namespace pysojic
+{
+    // Tell the CPU we are in a spin loop (pause on x86, yield on ARM)
+    inline void cpu_relax() noexcept
+    {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
+    }
+
+    struct BusySpinWait
+    {
+        template <typename Ready>
+        void wait(Ready&& ready)
+        {
+            while (!ready())
+            {
+            }
+        }
+
+        void notify() noexcept {}
+    };
+
+    struct PauseSpinWait
+    {
+        // Polls without pausing first: most waits are short and a pause costs up to ~100 cycles on recent x86
+        static constexpr int SPIN_COUNT = 64;
+
+        template <typename Ready>
+        void wait(Ready&& ready)
+        {
+            for (int i = 0; i < SPIN_COUNT; ++i)
+            {
+                if (ready())
+                    return;
+            }
+            while (!ready())
+                cpu_relax();
+        }
+
+        void notify() noexcept {}
+    };
+
+    // The publisher must not pay a system call on every publish, so the waiter raises m_Waiting before parking
+    // and the publisher only calls notify_one() when it sees the flag. The classic lost wake-up:
+    //   waiter: ready() is false ............................................. parks forever
+    //   publisher:                 publishes, sees no waiter flag, no notify
+    // is avoided with the store/fence/load pattern on both sides (Dekker):
+    //   waiter:    m_Waiting = true;  fence(seq_cst);  check ready()
+    //   publisher: publish;           fence(seq_cst);  check m_Waiting
+    // The two fences are ordered one way or the other, so either the waiter sees the publication (and does not
+    // park) or the publisher sees the flag (and wakes it up).
+    // What the publisher still pays on every publish is the fence (an mfence or locked instruction on x86, ~20-30
+    // cycles) and a load of m_Waiting, whose cache line stays shared as long as nobody parks.
+    class ParkingWait
+    {
+    public:
+        static constexpr int SPIN_COUNT = 64;
+        // About 10-50 microseconds of pausing (depending on the CPU) before parking
+        static constexpr int PAUSE_COUNT = 1000;
+
+        template <typename Ready>
+        void wait(Ready&& ready);
+
+        void notify() noexcept
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_Waiting.load(std::memory_order_relaxed))
+            {
+                m_Waiting.store(0, std::memory_order_relaxed);
+                m_Waiting.notify_one();
+            }
+        }
+
+    private:
+        // Own cache line: written only by the waiter when it parks, read by the publisher on every publish.
+        // 32 bits is what a futex waits on, so atomic::wait parks on the flag directly (no proxy).
+        alignas(64) std::atomic<std::uint32_t> m_Waiting{0};
+    };
+
+    //------------ Implementation ------------
+
+    template <typename Ready>
+    void ParkingWait::wait(Ready&& ready)
+    {
+        for (int i = 0; i < SPIN_COUNT; ++i)
+        {
+            if (ready())
+                return;
+        }
+        for (int i = 0; i < PAUSE_COUNT; ++i)
+        {
+            if (ready())
+                return;
+            cpu_relax();
+        }
+
+        for (;;)
+        {
+            m_Waiting.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ready())
+            {
+                m_Waiting.store(0, std::memory_order_relaxed);
+                return;
+            }
+            // Returns once notify() cleared the flag (or spuriously, hence the loop)
+            m_Waiting.wait(1, std::memory_order_relaxed);
+        }
+    }
+}
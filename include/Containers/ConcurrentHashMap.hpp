@@ -0,0 +1,197 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "Containers/OpenAddressingHashMap.hpp"
+#include "Concurrency/SpinLock.hpp"
+#include "Utilities/Hash.hpp"
+
+// Thread-safe hash map made of ShardCount independent OpenAddressingHashMaps, each protected by its own lock.
+// A key always lives in the same shard, so threads working on different shards never contend: with enough shards
+// (a few times the number of threads), most operations take an uncontended lock and touch a single cache line of
+// shared state.
+//
+// Lock is any type with lock()/unlock(): the project's SpinLock (default, best for very short critical sections)
+// or Mutex (parks the thread with atomic wait/notify), or std::mutex.
+//
+// Values are never handed out by reference since another thread could modify/remove them right after the lock
+// is released: either copy them out (find) or work on them under the shard lock (visit/update).
+namespace pysojic
+{
+    template <typename Key, typename Value, typename HashFunction = std::hash<Key>, typename KeyEqual = std::equal_to<Key>,
+              typename Lock = SpinLock, size_t ShardCount = 64>
+    class ConcurrentHashMap
+    {
+        static_assert(ShardCount >= 1 && (ShardCount & (ShardCount - 1)) == 0, "ShardCount must be a power of two");
+
+        // One shard per cache line (at least) so that two threads locking neighbouring shards do not false share
+        struct alignas(64) Shard
+        {
+            mutable Lock lock;
+            OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual> map;
+        };
+
+    public:
+        ConcurrentHashMap() = default;
+        // Locks cannot be copied or moved
+        ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+        ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+        void insert(const Key& key, const Value& val);
+        template <typename M>
+        bool insert_or_assign(const Key& key, M&& obj);
+        template <typename... Args>
+        bool try_emplace(const Key& key, Args&&... args);
+        bool erase(const Key& key);
+
+        std::optional<Value> find(const Key& key) const;
+        bool contains(const Key& key) const;
+
+        // Call f(const Value&) / f(Value&) under the shard lock if key is present. Returns whether it was.
+        template <typename F>
+        bool visit(const Key& key, F&& f) const;
+        template <typename F>
+        bool update(const Key& key, F&& f);
+        // Call f(const Key&, const Value&) on every element, one shard at a time (not a consistent snapshot)
+        template <typename F>
+        void visit_all(F&& f) const;
+
+        size_t size() const;
+        bool empty() const { return size() == 0; }
+        static constexpr size_t shard_count() noexcept { return ShardCount; }
+
+    private:
+        static size_t shard_index(const Key& key) noexcept;
+        Shard& shard_for(const Key& key) noexcept { return m_Shards[shard_index(key)]; }
+        const Shard& shard_for(const Key& key) const noexcept { return m_Shards[shard_index(key)]; }
+
+    private:
+        std::array<Shard, ShardCount> m_Shards;
+    };
+
+    //------------ Implementation ------------
+
+    // The shard maps index their slots with the low bits of the hash, so the shard is picked from the high bits
+    // of a Fibonacci hash (multiply by 2^64 / golden ratio): they depend on every bit of the hash, which matters for
+    // std::hash<int> being the identity.
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Lock, size_t ShardCount>
+    size_t ConcurrentHashMap<Key, Value, HashFunction, KeyEqual, Lock, ShardCount>::shard_index(const Key& key) noexcept
+    {
+        if constexpr (ShardCount == 1)
+        {
+            return 0;
+        }
+        else
+        {
+            return static_cast<size_t>(fibonacci_hash(HashFunction{}(key), std::countr_zero(ShardCount)));
+        }
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Lock, size_t ShardCount>
+    void ConcurrentHashMap<Key, Value, HashFunction, KeyEqual, Lock, ShardCount>::insert(const Key& key, const Value& val)
+    {
+        Shard& shard = shard_for(key);
+        std::lock_guard guard{shard.lock};
+        shard.map.insert(key, val);
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Lock, size_t ShardCount>
+    template <typename M>
+    bool ConcurrentHashMap<Key, Value, HashFunction, KeyEqual, Lock, ShardCount>::insert_or_assign(const Key& key, M&& obj)
+    {
+        Shard& shard = shard_for(key);
+        std::lock_guard guard{shard.lock};
+        return shard.map.insert_or_assign(key, std::forward<M>(obj)).second;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Lock, size_t ShardCount>
+    template <typename... Args>
+    bool ConcurrentHashMap<Key, Value, HashFunction, KeyEqual, Lock, ShardCount>::try_emplace(const Key& key, Args&&... args)
+    {
+        Shard& shard = shard_for(key);
+        std::lock_guard guard{shard.lock};
+        return shard.map.try_emplace(key, std::forward<Args>(args)...).second;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Lock, size_t ShardCount>
+    bool ConcurrentHashMap<Key, Value, HashFunction, KeyEqual, Lock, ShardCount>::erase(const Key& key)
+    {
+        Shard& shard = shard_for(key);
+        std::lock_guard guard{shard.lock};
+        return shard.map.erase(key) != 0;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Lock, size_t ShardCount>
+    std::optional<Value> ConcurrentHashMap<Key, Value, HashFunction, KeyEqual, Lock, ShardCount>::find(const Key& key) const
+    {
+        const Shard& shard = shard_for(key);
+        std::lock_guard guard{shard.lock};
+        if (auto it = shard.map.find(key); it != shard.map.end())
+            return (*it).second;
+        return std::nullopt;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Lock, size_t ShardCount>
+    bool ConcurrentHashMap<Key, Value, HashFunction, KeyEqual, Lock, ShardCount>::contains(const Key& key) const
+    {
+        const Shard& shard = shard_for(key);
+        std::lock_guard guard{shard.lock};
+        return shard.map.contains(key);
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Lock, size_t ShardCount>
+    template <typename F>
+    bool ConcurrentHashMap<Key, Value, HashFunction, KeyEqual, Lock, ShardCount>::visit(const Key& key, F&& f) const
+    {
+        const Shard& shard = shard_for(key);
+        std::lock_guard guard{shard.lock};
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+            return false;
+        std::invoke(std::forward<F>(f), (*it).second);
+        return true;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Lock, size_t ShardCount>
+    template <typename F>
+    bool ConcurrentHashMap<Key, Value, HashFunction, KeyEqual, Lock, ShardCount>::update(const Key& key, F&& f)
+    {
+        Shard& shard = shard_for(key);
+        std::lock_guard guard{shard.lock};
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+            return false;
+        std::invoke(std::forward<F>(f), (*it).second);
+        return true;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Lock, size_t ShardCount>
+    template <typename F>
+    void ConcurrentHashMap<Key, Value, HashFunction, KeyEqual, Lock, ShardCount>::visit_all(F&& f) const
+    {
+        for (const Shard& shard : m_Shards)
+        {
+            std::lock_guard guard{shard.lock};
+            for (auto&& [key, value] : shard.map)
+                std::invoke(f, key, value);
+        }
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Lock, size_t ShardCount>
+    size_t ConcurrentHashMap<Key, Value, HashFunction, KeyEqual, Lock, ShardCount>::size() const
+    {
+        size_t total = 0;
+        for (const Shard& shard : m_Shards)
+        {
+            std::lock_guard guard{shard.lock};
+            total += shard.map.size();
+        }
+        return total;
+    }
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <vector>
+#include <stdexcept>
+#include <utility>
+
+#include "Utilities/Hash.hpp"
+
+// Separate chaining without nodes.
+// HashMap keeps a std::list per bucket: one allocation per element, a pointer chase per step in a chain, and a rehash
+// that moves every pair into freshly allocated nodes. Here all the entries live in one contiguous dense array and
+// a chain is just a sequence of indices into that array:
+//   m_Buckets[b]  -> index of the first entry of bucket b (or npos)
+//   m_Next[i]     -> index of the entry following entry i in its bucket (or npos)
+// Iterating over the map is a linear walk over m_Entries, and rehashing only rewrites indices.
+// Removing an element moves the last entry into the hole (swap and pop), so iteration order is not stable across removals.
+namespace pysojic
+{
+    template <typename Key, typename Value, typename HashFunction = std::hash<Key>>
+    class DenseHashMap
+    {
+    public:
+        using const_iterator = typename std::vector<std::pair<Key, Value>>::const_iterator;
+
+        DenseHashMap();
+
+        void rehash(size_t count);
+        void reserve(size_t count);
+        void insert(const Key& key, const Value& val);
+        void remove(const Key& key);
+        Value& operator[](const Key& key);
+
+        const Value& at(const Key& key) const;
+        bool contains(const Key& key) const;
+        bool empty() const noexcept { return m_Entries.empty(); }
+        size_t size() const noexcept { return m_Entries.size(); }
+        size_t bucket_count() const noexcept { return m_Buckets.size(); }
+        double load_factor() const noexcept;
+
+        // Read-only iteration over the dense array (keys must never be modified in place)
+        const_iterator begin() const noexcept { return m_Entries.cbegin(); }
+        const_iterator end() const noexcept { return m_Entries.cend(); }
+
+    private:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        size_t hash_function(const Key& key) const;
+        size_t hash_function(const Key& key, size_t newBucketCount) const;
+        size_t find_index(const Key& key) const;
+        size_t append(const Key& key, const Value& val);
+
+    private:
+        std::vector<std::pair<Key, Value>> m_Entries;
+        std::vector<size_t> m_Next;
+        std::vector<size_t> m_Buckets;
+        double m_MaxLoadFactor;
+        inline static size_t m_InitialBucketCount = 16;
+    };
+
+    //------------Implementation--------------
+
+    template <typename Key, typename Value, typename HashFunction>
+    size_t DenseHashMap<Key, Value, HashFunction>::hash_function(const Key& key) const
+    {
+        return mixed_hash<HashFunction>(key) & (m_Buckets.size() - 1);
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    size_t DenseHashMap<Key, Value, HashFunction>::hash_function(const Key& key, size_t newBucketCount) const
+    {
+        return mixed_hash<HashFunction>(key) & (newBucketCount - 1);
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    DenseHashMap<Key, Value, HashFunction>::DenseHashMap()
+        : m_Buckets(m_InitialBucketCount, npos), m_MaxLoadFactor{1.0}
+    {}
+
+    // Only the index chains are rebuilt, the entries themselves never move
+    template <typename Key, typename Value, typename HashFunction>
+    void DenseHashMap<Key, Value, HashFunction>::rehash(size_t count)
+    {
+        if (count > m_Buckets.size())
+        {
+            m_Buckets.assign(count, npos);
+            for (size_t i = 0; i < m_Entries.size(); ++i)
+            {
+                size_t newHash = hash_function(m_Entries[i].first, count);
+                m_Next[i] = m_Buckets[newHash];
+                m_Buckets[newHash] = i;
+            }
+        }
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    void DenseHashMap<Key, Value, HashFunction>::reserve(size_t count)
+    {
+        m_Entries.reserve(count);
+        m_Next.reserve(count);
+
+        size_t bucketCount = m_Buckets.size();
+        while (count > bucketCount * m_MaxLoadFactor)
+            bucketCount *= 2;
+        rehash(bucketCount);
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    size_t DenseHashMap<Key, Value, HashFunction>::find_index(const Key& key) const
+    {
+        for (size_t i = m_Buckets[hash_function(key)]; i != npos; i = m_Next[i])
+        {
+            if (m_Entries[i].first == key)
+                return i;
+        }
+        return npos;
+    }
+
+    // Append a new entry (the key is known to be absent) and link it at the head of its bucket
+    template <typename Key, typename Value, typename HashFunction>
+    size_t DenseHashMap<Key, Value, HashFunction>::append(const Key& key, const Value& val)
+    {
+        size_t hashVal = hash_function(key);
+        size_t index = m_Entries.size();
+
+        m_Entries.emplace_back(key, val);
+        try
+        {
+            m_Next.push_back(m_Buckets[hashVal]);
+        }
+        catch (...)
+        {
+            m_Entries.pop_back(); // keep m_Entries and m_Next the same length
+            throw;
+        }
+        m_Buckets[hashVal] = index;
+
+        if (load_factor() > m_MaxLoadFactor)
+            rehash(m_Buckets.size() * 2);
+
+        return index;
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    void DenseHashMap<Key, Value, HashFunction>::insert(const Key& key, const Value& val)
+    {
+        size_t index = find_index(key);
+        if (index != npos)
+        {
+            m_Entries[index].second = val;
+            return;
+        }
+        append(key, val);
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    void DenseHashMap<Key, Value, HashFunction>::remove(const Key& key)
+    {
+        // Unlink the entry from its chain
+        size_t* link = &m_Buckets[hash_function(key)];
+        while (*link != npos && !(m_Entries[*link].first == key))
+            link = &m_Next[*link];
+
+        if (*link == npos)
+            throw std::out_of_range("Key not found");
+
+        size_t index = *link;
+        *link = m_Next[index];
+
+        // Fill the hole with the last entry and redirect whatever pointed to it
+        size_t last = m_Entries.size() - 1;
+        if (index != last)
+        {
+            link = &m_Buckets[hash_function(m_Entries[last].first)];
+            while (*link != last)
+                link = &m_Next[*link];
+            *link = index;
+
+            m_Entries[index] = std::move(m_Entries[last]);
+            m_Next[index] = m_Next[last];
+        }
+
+        m_Entries.pop_back();
+        m_Next.pop_back();
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    Value& DenseHashMap<Key, Value, HashFunction>::operator[] (const Key& key)
+    {
+        size_t index = find_index(key);
+        if (index == npos)
+            index = append(key, Value{});
+        return m_Entries[index].second;
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    const Value& DenseHashMap<Key, Value, HashFunction>::at(const Key& key) const
+    {
+        size_t index = find_index(key);
+        if (index == npos)
+            throw std::out_of_range{"Key not found"};
+        return m_Entries[index].second;
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    bool DenseHashMap<Key, Value, HashFunction>::contains(const Key& key) const
+    {
+        return find_index(key) != npos;
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    double DenseHashMap<Key, Value, HashFunction>::load_factor() const noexcept
+    {
+        return static_cast<double>(m_Entries.size()) / m_Buckets.size();
+    }
+}
@@ -3,112 +3,451 @@
 #include <vector>
 #include <list>
 #include <tuple>
+#include <iterator>
 #include <stdexcept>
+#include <functional>
+#include <utility>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <algorithm>
 
+#include "Utilities/Hash.hpp"
+#include "Utilities/Prefetch.hpp"
+
+// Incremental rehashing (set_incremental_rehash(true)):
+// a regular rehash relinks every node of the table inside the one insert that crosses the max load factor, which
+// is a latency spike of several milliseconds on big tables. In incremental mode that insert only allocates the new
+// bucket array; the old one is kept alongside it and every following insertion moves a few old buckets over
+// (the way Redis' dict does it). A key lives in exactly one of the two tables, so lookups check its old bucket
+// (if not migrated yet) and then its new one, and new keys always go to the new table.
+// Old buckets are migrated from the back and popped, so the old array shrinks as it empties.
+// Allocating the new bucket array is O(n) too (mostly page faults when its memory is first written), so it is
+// built ahead of time: past 3/4 of the max load factor, every insertion also appends a few empty buckets to it.
 namespace pysojic
 {
-    template <typename Key, typename Value, typename HashFunction = std::hash<Key>>
+    // Allocator is used for both the nodes (rebound to the node type by std::list) and the bucket array.
+    // With a std::pmr::polymorphic_allocator (see pysojic::pmr::HashMap below) the whole map, and the keys/values if
+    // they are pmr-aware themselves, live in the given memory_resource: a map backed by a monotonic_buffer_resource
+    // allocates by bumping a pointer and all its memory is released at once with the arena.
+    template <typename Key, typename Value, typename HashFunction = std::hash<Key>, typename KeyEqual = std::equal_to<Key>,
+              typename Allocator = std::allocator<std::pair<Key, Value>>>
     class HashMap
     {
+        using AllocTraits = std::allocator_traits<Allocator>;
+        using Bucket = std::list<std::pair<Key, Value>, typename AllocTraits::template rebind_alloc<std::pair<Key, Value>>>;
+        using BucketVector = std::vector<Bucket, typename AllocTraits::template rebind_alloc<Bucket>>;
+
+        // Walks the buckets in order, skipping the empty ones.
+        // Same guarantees as std::unordered_map: references and pointers to elements survive a rehash, iterators do
+        // not (they remember the bucket they are in). Any insertion that grows the table invalidates them, and in
+        // incremental mode so does every insertion, since each one migrates a few buckets (as does
+        // set_incremental_rehash(false), which finishes the migration).
+        template <bool IsConst>
+        class Iterator
+        {
+            friend class HashMap;
+            template <bool> friend class Iterator;
+
+            using Map = std::conditional_t<IsConst, const HashMap, HashMap>;
+            using BucketIterator = std::conditional_t<IsConst, typename Bucket::const_iterator, typename Bucket::iterator>;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<Key, Value>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+            using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+            Iterator() = default;
+            // iterator -> const_iterator
+            template <bool OtherConst> requires (IsConst && !OtherConst)
+            Iterator(const Iterator<OtherConst>& other)
+                : m_Map{other.m_Map}, m_Index{other.m_Index}, m_It{other.m_It}
+            {}
+
+            reference operator*() const { return *m_It; }
+            pointer operator->() const { return &*m_It; }
+            Iterator& operator++() { ++m_It; skip_empty_buckets(); return *this; }
+            Iterator operator++(int) { Iterator tmp = *this; ++*this; return tmp; }
+            bool operator==(const Iterator& other) const { return m_Index == other.m_Index && m_It == other.m_It; }
+
+        private:
+            Iterator(Map* map, size_t index, BucketIterator it)
+                : m_Map{map}, m_Index{index}, m_It{it}
+            {}
+
+            // begin(): first element of the first non-empty bucket at or after index
+            Iterator(Map* map, size_t index)
+                : m_Map{map}, m_Index{index}
+            {
+                if (m_Index < m_Map->bucket_slots())
+                {
+                    m_It = m_Map->bucket_at(m_Index).begin();
+                    skip_empty_buckets();
+                }
+            }
+
+            // end() is represented by m_Index == bucket count and a value-initialized list iterator
+            void skip_empty_buckets()
+            {
+                while (m_It == m_Map->bucket_at(m_Index).end())
+                {
+                    if (++m_Index == m_Map->bucket_slots())
+                    {
+                        m_It = BucketIterator{};
+                        return;
+                    }
+                    m_It = m_Map->bucket_at(m_Index).begin();
+                }
+            }
+
+        private:
+            Map* m_Map = nullptr;
+            size_t m_Index = 0;
+            BucketIterator m_It{};
+        };
+
     public:
-        HashMap();
+        using key_type = Key;
+        using mapped_type = Value;
+        using value_type = std::pair<Key, Value>;
+        using allocator_type = Allocator;
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        // An element extracted from the map (or nothing), see extract()/insert(NodeHandle&&).
+        // It owns the list node itself: extracting and inserting back relinks it, the key and value are never
+        // copied or moved and nothing is allocated. The key can be modified in between.
+        class NodeHandle
+        {
+            friend class HashMap;
+        public:
+            NodeHandle() = default;
+
+            bool empty() const noexcept { return m_Node.empty(); }
+            explicit operator bool() const noexcept { return !m_Node.empty(); }
+            Key& key() { return m_Node.front().first; }
+            Value& mapped() { return m_Node.front().second; }
+            allocator_type get_allocator() const { return allocator_type(m_Node.get_allocator()); }
+
+        private:
+            explicit NodeHandle(const Bucket& bucket) : m_Node(bucket.get_allocator()) {}
+
+        private:
+            Bucket m_Node; // zero or one element
+        };
+        using node_type = NodeHandle;
+
+        struct InsertReturn
+        {
+            iterator position;
+            bool inserted;
+            node_type node; // the node given to insert() if the key was already there, empty otherwise
+        };
+        using insert_return_type = InsertReturn;
+
+        HashMap() : HashMap(Allocator{}) {}
+        explicit HashMap(const Allocator& alloc);
         HashMap(const HashMap& other);
         HashMap& operator=(const HashMap& other);
         HashMap(HashMap&& other) noexcept;
         HashMap& operator=(HashMap&& other) noexcept;
-        
+
         void rehash(size_t count);
         void insert(const Key& key, const Value& val);
-        void remove(const Key& key);
-        Value& operator[](const Key& key);
-        
-        const Value& at(const Key& key) const;
-        void find(const Key& key) const;
+        void remove(const Key& key) { remove_impl(key); }
+        Value& operator[](const Key& key) { return try_emplace_impl(key).first->second; }
+        Value& operator[](Key&& key) { return try_emplace_impl(std::move(key)).first->second; }
+
+        // Insert or overwrite, moving the key/value in when given rvalues
+        template <typename M>
+        std::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) { return insert_or_assign_impl(key, std::forward<M>(obj)); }
+        template <typename M>
+        std::pair<iterator, bool> insert_or_assign(Key&& key, M&& obj) { return insert_or_assign_impl(std::move(key), std::forward<M>(obj)); }
+        // The value is constructed in place from args, and only if the key is absent
+        template <typename... Args>
+        std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) { return try_emplace_impl(key, std::forward<Args>(args)...); }
+        template <typename... Args>
+        std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) { return try_emplace_impl(std::move(key), std::forward<Args>(args)...); }
+        template <typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args);
+
+        // Unlike remove(), erasing an absent key is not an error: returns the number of elements erased (0 or 1)
+        size_t erase(const Key& key) { return erase_impl(key); }
+        // Returns the iterator following pos. Iterators to other elements stay valid.
+        iterator erase(const_iterator pos);
+        iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+        // Unlink the element's node from the map (an empty node if key is absent)
+        node_type extract(const_iterator pos);
+        node_type extract(const Key& key);
+        // Link the node in if its key is absent. Otherwise the node is handed back in the result.
+        // As with std::unordered_map, node.get_allocator() must compare equal to get_allocator().
+        insert_return_type insert(node_type&& node);
+
+        Value& at(const Key& key) { return at_impl(key); }
+        const Value& at(const Key& key) const { return const_cast<HashMap&>(*this).at_impl(key); }
+        iterator find(const Key& key) { return find_impl(key); }
+        const_iterator find(const Key& key) const { return const_cast<HashMap&>(*this).find_impl(key); }
+        bool contains(const Key& key) const { return find(key) != end(); }
+
+        // Batched lookup: out[i] = find(keys[i]). On tables that do not fit in cache, every find() is two dependent
+        // cache misses (bucket, then first node) the CPU waits for; here the keys of a chunk are hashed and their
+        // buckets prefetched, then their first nodes, before any of them is searched, so the misses overlap.
+        void find_batch(std::span<const Key> keys, std::span<iterator> out);
+        void find_batch(std::span<const Key> keys, std::span<const_iterator> out) const;
+
+        // Heterogeneous lookup (e.g. std::string keys queried with a std::string_view or a const char*),
+        // enabled when both HashFunction and KeyEqual are transparent, see Utilities/Hash.hpp
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        void remove(const K& key) { remove_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        size_t erase(const K& key) { return erase_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        Value& operator[](K&& key) { return try_emplace_impl(std::forward<K>(key)).first->second; }
+        template <typename K, typename M> requires TransparentHash<HashFunction, KeyEqual>
+        std::pair<iterator, bool> insert_or_assign(K&& key, M&& obj) { return insert_or_assign_impl(std::forward<K>(key), std::forward<M>(obj)); }
+        template <typename K, typename... Args> requires TransparentHash<HashFunction, KeyEqual>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) { return try_emplace_impl(std::forward<K>(key), std::forward<Args>(args)...); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        Value& at(const K& key) { return at_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        const Value& at(const K& key) const { return const_cast<HashMap&>(*this).at_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        iterator find(const K& key) { return find_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        const_iterator find(const K& key) const { return const_cast<HashMap&>(*this).find_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        bool contains(const K& key) const { return find(key) != end(); }
+
+        iterator begin() { return iterator(this, 0); }
+        const_iterator begin() const { return const_iterator(this, 0); }
+        iterator end() { return iterator(this, bucket_slots(), {}); }
+        const_iterator end() const { return const_iterator(this, bucket_slots(), {}); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
         bool empty() const noexcept;
         size_t size() const noexcept;
         double load_factor() const noexcept;
-        
+        allocator_type get_allocator() const { return allocator_type(m_Buckets.get_allocator()); }
+
+        // Spread the cost of growing over the following insertions instead of paying it in one go.
+        // Turning it off finishes any migration in progress.
+        void set_incremental_rehash(bool enabled);
+        bool incremental_rehash() const noexcept { return m_IncrementalRehash; }
+        bool rehash_in_progress() const noexcept { return !m_OldBuckets.empty(); }
+
     private:
-        size_t hash_function(const Key& key) const;
-        size_t hash_function(const Key& key, size_t newBucketCount) const;
+        template <typename K>
+        size_t hash_function(const K& key) const;
+        template <typename K>
+        size_t hash_function(const K& key, size_t newBucketCount) const;
+
+        // Every list must use the map's allocator, splicing nodes between lists with different allocators is UB
+        Bucket make_bucket() const { return Bucket(m_Buckets.get_allocator()); }
+
+        // Iterators see the old buckets (while migrating) followed by the current ones as a single sequence
+        size_t bucket_slots() const noexcept { return m_OldBuckets.size() + m_Buckets.size(); }
+        Bucket& bucket_at(size_t index) { return index < m_OldBuckets.size() ? m_OldBuckets[index] : m_Buckets[index - m_OldBuckets.size()]; }
+        const Bucket& bucket_at(size_t index) const { return index < m_OldBuckets.size() ? m_OldBuckets[index] : m_Buckets[index - m_OldBuckets.size()]; }
+
+        template <typename K>
+        static typename Bucket::iterator find_in_bucket(Bucket& bucket, const K& key);
+        iterator insert_node(size_t hash, Bucket& node);
+        void grow();
+        void migrate(size_t bucketCount);
+        void prepare_next_buckets();
+
+        template <typename K>
+        iterator find_impl(const K& key, size_t hash);
+        template <typename K>
+        iterator find_impl(const K& key) { return find_impl(key, mixed_hash<HashFunction>(key)); }
+        // Calls emit(i, find(keys[i])) for every key
+        template <typename F>
+        void find_batch_impl(std::span<const Key> keys, F&& emit);
+        template <typename K>
+        Value& at_impl(const K& key);
+        template <typename K>
+        void remove_impl(const K& key);
+        template <typename K>
+        size_t erase_impl(const K& key);
+        template <typename K, typename... Args>
+        std::pair<iterator, bool> try_emplace_impl(K&& key, Args&&... args);
+        template <typename K, typename M>
+        std::pair<iterator, bool> insert_or_assign_impl(K&& key, M&& obj);
 
     private:
-        std::vector<std::list<std::pair<Key, Value>>> m_Buckets;
+        BucketVector m_Buckets;
+        // Buckets of the previous table not migrated yet, only non-empty while an incremental rehash is in progress
+        BucketVector m_OldBuckets;
+        size_t m_OldBucketCount = 0;
+        // Bucket array for the next growth, built a few buckets at a time
+        BucketVector m_NextBuckets;
         size_t m_NumElems;
         double m_MaxLoadFactor;
+        bool m_IncrementalRehash = false;
         inline static size_t m_InitialBucketCount = 16;
+        // Old buckets moved per insertion: with a max load factor of 1 and doubling, one per insertion is enough to
+        // finish before the new table needs to grow again
+        static constexpr size_t m_MigrationStep = 4;
+        // Next buckets built per insertion: 2n of them between 3n/4 and n elements, i.e. at least 8 per insertion
+        static constexpr size_t m_PrepareStep = 16;
     };
 
     //------------Implementation--------------
 
-    template <typename Key, typename Value, typename HashFunction>
-    size_t HashMap<Key, Value, HashFunction>::hash_function(const Key& key) const
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    template <typename K>
+    size_t HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::hash_function(const K& key) const
     {
-        return HashFunction{}(key) & (m_Buckets.size() - 1);
+        return mixed_hash<HashFunction>(key) & (m_Buckets.size() - 1);
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    size_t HashMap<Key, Value, HashFunction>::hash_function(const Key& key, size_t newBucketCount) const
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    template <typename K>
+    size_t HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::hash_function(const K& key, size_t newBucketCount) const
     {
-        return HashFunction{}(key) & (newBucketCount - 1);
+        return mixed_hash<HashFunction>(key) & (newBucketCount - 1);
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    void HashMap<Key, Value, HashFunction>::rehash(size_t count) 
+    // Nodes are spliced into the new buckets: no allocation, no copy, and references to the elements stay valid
+    // (iterators do not: they hold the index of the bucket the node was in)
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    void HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::rehash(size_t count)
     {
+        migrate(m_OldBuckets.size());
+
         size_t bucketsCount = m_Buckets.size();
         if (count > bucketsCount)
         {
-            std::vector<std::list<std::pair<Key, Value>>> newBuckets(count);
-            
+            BucketVector newBuckets(count, make_bucket(), m_Buckets.get_allocator());
+
             for (auto& list : m_Buckets)
-                for (auto& pair : list)
+                while (!list.empty())
                 {
-                    size_t newHash = hash_function(pair.first, count);
-                    newBuckets[newHash].push_back(std::move(pair));
+                    size_t newHash = hash_function(list.front().first, count);
+                    newBuckets[newHash].splice(newBuckets[newHash].end(), list, list.begin());
                 }
             m_Buckets = std::move(newBuckets);
         }
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    HashMap<Key, Value, HashFunction>::HashMap()
-        : m_Buckets{m_InitialBucketCount}, m_NumElems{}, m_MaxLoadFactor{1.0}
+    // Move up to bucketCount old buckets (starting from the back) into the current table
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    void HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::migrate(size_t bucketCount)
+    {
+        for (; bucketCount > 0 && !m_OldBuckets.empty(); --bucketCount)
+        {
+            auto& list = m_OldBuckets.back();
+            while (!list.empty())
+            {
+                size_t newHash = hash_function(list.front().first);
+                m_Buckets[newHash].splice(m_Buckets[newHash].end(), list, list.begin());
+            }
+            m_OldBuckets.pop_back();
+        }
+
+        if (m_OldBuckets.empty() && m_OldBuckets.capacity() != 0)
+        {
+            BucketVector(m_Buckets.get_allocator()).swap(m_OldBuckets);
+            m_OldBucketCount = 0;
+        }
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    void HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::grow()
+    {
+        if (!m_IncrementalRehash)
+        {
+            rehash(m_Buckets.size() * 2);
+            return;
+        }
+
+        // Only possible if the previous migration was outpaced, finish it first
+        migrate(m_OldBuckets.size());
+
+        // Normally already done by prepare_next_buckets()
+        m_NextBuckets.resize(m_Buckets.size() * 2, make_bucket());
+
+        m_OldBucketCount = m_Buckets.size();
+        m_OldBuckets = std::move(m_Buckets);
+        m_Buckets = std::move(m_NextBuckets);
+        m_NextBuckets.clear();
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    void HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::prepare_next_buckets()
+    {
+        if (load_factor() < 0.75 * m_MaxLoadFactor)
+            return;
+
+        size_t count = m_Buckets.size() * 2;
+        if (m_NextBuckets.capacity() < count)
+            m_NextBuckets.reserve(count); // no memory is touched yet
+        for (size_t i = 0; i < m_PrepareStep && m_NextBuckets.size() < count; ++i)
+            m_NextBuckets.push_back(make_bucket());
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    void HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::set_incremental_rehash(bool enabled)
+    {
+        if (!enabled)
+        {
+            migrate(m_OldBuckets.size());
+            BucketVector(m_Buckets.get_allocator()).swap(m_NextBuckets);
+        }
+        m_IncrementalRehash = enabled;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::HashMap(const Allocator& alloc)
+        : m_Buckets(m_InitialBucketCount, Bucket(alloc), alloc), m_OldBuckets(alloc), m_NextBuckets(alloc),
+        m_NumElems{}, m_MaxLoadFactor{1.0}
     {}
 
-    template <typename Key, typename Value, typename HashFunction>
-    HashMap<Key, Value, HashFunction>::HashMap(const HashMap& other)
-        : m_Buckets{other.m_Buckets}, m_NumElems{other.m_NumElems}, m_MaxLoadFactor{other.m_MaxLoadFactor}
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::HashMap(const HashMap& other)
+        : m_Buckets{other.m_Buckets}, m_OldBuckets{other.m_OldBuckets}, m_OldBucketCount{other.m_OldBucketCount},
+        m_NextBuckets(m_Buckets.get_allocator()), m_NumElems{other.m_NumElems}, m_MaxLoadFactor{other.m_MaxLoadFactor}, m_IncrementalRehash{other.m_IncrementalRehash}
     {}
 
-    template <typename Key, typename Value, typename HashFunction>
-    auto HashMap<Key, Value, HashFunction>::operator= (const HashMap& other) -> HashMap&
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::operator= (const HashMap& other) -> HashMap&
     {
         if (this != &other)
         {
             m_Buckets = other.m_Buckets;
+            m_OldBuckets = other.m_OldBuckets;
+            m_OldBucketCount = other.m_OldBucketCount;
             m_NumElems = other.m_NumElems;
             m_MaxLoadFactor = other.m_MaxLoadFactor;
+            m_IncrementalRehash = other.m_IncrementalRehash;
         }
 
         return *this;
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    HashMap<Key, Value, HashFunction>::HashMap(HashMap&& other) noexcept
-        : m_Buckets{std::move(other.m_Buckets)}, m_NumElems{std::exchange(other.m_NumElems, 0)}, 
-        m_MaxLoadFactor{std::exchange(other.m_MaxLoadFactor, 0 )}
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::HashMap(HashMap&& other) noexcept
+        : m_Buckets{std::move(other.m_Buckets)}, m_OldBuckets{std::move(other.m_OldBuckets)},
+        m_OldBucketCount{std::exchange(other.m_OldBucketCount, 0)}, m_NextBuckets(m_Buckets.get_allocator()), m_NumElems{std::exchange(other.m_NumElems, 0)},
+        m_MaxLoadFactor{std::exchange(other.m_MaxLoadFactor, 0 )}, m_IncrementalRehash{other.m_IncrementalRehash}
     {}
 
-    template <typename Key, typename Value, typename HashFunction>
-    auto HashMap<Key, Value, HashFunction>::operator= (HashMap&& other) noexcept -> HashMap&
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::operator= (HashMap&& other) noexcept -> HashMap&
     {
         if (this != &other)
         {
             m_Buckets = std::move(other.m_Buckets);
+            m_OldBuckets = std::move(other.m_OldBuckets);
+            m_OldBucketCount = other.m_OldBucketCount;
             m_NumElems = other.m_NumElems;
             m_MaxLoadFactor = other.m_MaxLoadFactor;
+            m_IncrementalRehash = other.m_IncrementalRehash;
 
+            other.m_OldBucketCount = 0;
             other.m_NumElems = 0;
             other.m_MaxLoadFactor = 0;
         }
@@ -116,104 +455,264 @@ namespace pysojic
         return *this;
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    void HashMap<Key, Value, HashFunction>::insert(const Key& key, const Value& val)
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    template <typename K>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::find_in_bucket(Bucket& bucket, const K& key) -> typename Bucket::iterator
     {
-        size_t hashVal = hash_function(key);
-        
-        for (auto& [k, v] : m_Buckets[hashVal])
+        for (auto it = bucket.begin(); it != bucket.end(); ++it)
         {
-            if (k == key)
-            {
-                v = val;
-                return;
-            }
+            if (KeyEqual{}(it->first, key))
+                return it;
         }
+        return bucket.end();
+    }
 
-        m_Buckets[hashVal].push_back({key, val});
-        ++m_NumElems;
+    // While migrating, the key is either still in its old bucket (if that one was not moved yet) or in the new table
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    template <typename K>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::find_impl(const K& key, size_t hash) -> iterator
+    {
+        if (size_t oldIndex = hash & (m_OldBucketCount - 1); oldIndex < m_OldBuckets.size())
+        {
+            auto& bucket = m_OldBuckets[oldIndex];
+            if (auto it = find_in_bucket(bucket, key); it != bucket.end())
+                return iterator(this, oldIndex, it);
+        }
 
-        if (load_factor() > m_MaxLoadFactor)
-            rehash(m_Buckets.size() * 2);
+        size_t index = hash & (m_Buckets.size() - 1);
+        auto& bucket = m_Buckets[index];
+        if (auto it = find_in_bucket(bucket, key); it != bucket.end())
+            return iterator(this, m_OldBuckets.size() + index, it);
+
+        return end();
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    void HashMap<Key, Value, HashFunction>::remove(const Key& key)
+    // Chunks of 16 keep the number of prefetches in flight around what a core can track (10-20 outstanding misses)
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    template <typename F>
+    void HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::find_batch_impl(std::span<const Key> keys, F&& emit)
     {
-        size_t hashVal = hash_function(key);
+        constexpr size_t chunk = 16;
+        size_t hashes[chunk];
+        Bucket* buckets[chunk];
 
-        for (auto it = m_Buckets[hashVal].begin(); it != m_Buckets[hashVal].end(); ++it)
+        for (size_t first = 0; first < keys.size(); first += chunk)
         {
-            if (it->first == key)
+            size_t count = std::min(chunk, keys.size() - first);
+
+            for (size_t i = 0; i < count; ++i)
             {
-                m_Buckets[hashVal].erase(it);
-                --m_NumElems;
-                return;
+                hashes[i] = mixed_hash<HashFunction>(keys[first + i]);
+                buckets[i] = &m_Buckets[hashes[i] & (m_Buckets.size() - 1)];
+                prefetch_read(buckets[i]);
+                if (size_t oldIndex = hashes[i] & (m_OldBucketCount - 1); oldIndex < m_OldBuckets.size())
+                    prefetch_read(&m_OldBuckets[oldIndex]);
             }
+
+            // The buckets are (hopefully) in cache by now, start loading the nodes they point to
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (!buckets[i]->empty())
+                    prefetch_read(&buckets[i]->front());
+            }
+
+            for (size_t i = 0; i < count; ++i)
+                emit(first + i, find_impl(keys[first + i], hashes[i]));
         }
+    }
 
-        throw std::out_of_range("Key not found");
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    void HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::find_batch(std::span<const Key> keys, std::span<iterator> out)
+    {
+        if (keys.size() != out.size())
+            throw std::invalid_argument("find_batch: keys and out must have the same size");
+        find_batch_impl(keys, [&](size_t i, iterator it) { out[i] = it; });
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    Value& HashMap<Key, Value, HashFunction>::operator[] (const Key& key)
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    void HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::find_batch(std::span<const Key> keys, std::span<const_iterator> out) const
+    {
+        if (keys.size() != out.size())
+            throw std::invalid_argument("find_batch: keys and out must have the same size");
+        const_cast<HashMap&>(*this).find_batch_impl(keys, [&](size_t i, iterator it) { out[i] = it; });
+    }
+
+    // Link node (a one-element list) into the table, growing or moving a few old buckets first if needed.
+    // The node itself never moves (see rehash), only the bucket it belongs to may change.
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::insert_node(size_t hash, Bucket& node) -> iterator
     {
-        size_t hashVal = hash_function(key);
-        
-        for (auto& [k, v] : m_Buckets[hashVal])
-        {
-            if (k == key)
-                return v;
-        }
-        
-        m_Buckets[hashVal].push_back({key, Value{}});
         ++m_NumElems;
 
         if (load_factor() > m_MaxLoadFactor)
+            grow();
+        if (m_IncrementalRehash)
         {
-            rehash(m_Buckets.size() * 2);
-            hashVal = hash_function(key);
+            migrate(m_MigrationStep);
+            prepare_next_buckets();
+        }
+
+        size_t index = hash & (m_Buckets.size() - 1);
+        auto& bucket = m_Buckets[index];
+        bucket.splice(bucket.end(), node);
+        return iterator(this, m_OldBuckets.size() + index, std::prev(bucket.end()));
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    void HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::insert(const Key& key, const Value& val)
+    {
+        insert_or_assign_impl(key, val);
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    template <typename K, typename M>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::insert_or_assign_impl(K&& key, M&& obj) -> std::pair<iterator, bool>
+    {
+        size_t hash = mixed_hash<HashFunction>(key);
+
+        if (auto it = find_impl(key, hash); it != end())
+        {
+            it->second = std::forward<M>(obj);
+            return {it, false};
         }
 
-        for (auto& [k, v] : m_Buckets[hashVal])
+        Bucket node = make_bucket();
+        node.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                          std::forward_as_tuple(std::forward<M>(obj)));
+        return {insert_node(hash, node), true};
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    template <typename K, typename... Args>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::try_emplace_impl(K&& key, Args&&... args) -> std::pair<iterator, bool>
+    {
+        size_t hash = mixed_hash<HashFunction>(key);
+
+        if (auto it = find_impl(key, hash); it != end())
+            return {it, false};
+
+        Bucket node = make_bucket();
+        node.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                          std::forward_as_tuple(std::forward<Args>(args)...));
+        return {insert_node(hash, node), true};
+    }
+
+    // The key is only known once the pair is built, so build it in a one-node list first:
+    // if the key is new, the node is spliced into its bucket without any further allocation or move.
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    template <typename... Args>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::emplace(Args&&... args) -> std::pair<iterator, bool>
+    {
+        Bucket node = make_bucket();
+        node.emplace_back(std::forward<Args>(args)...);
+
+        size_t hash = mixed_hash<HashFunction>(node.front().first);
+
+        if (auto it = find_impl(node.front().first, hash); it != end())
+            return {it, false};
+
+        return {insert_node(hash, node), true};
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    template <typename K>
+    void HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::remove_impl(const K& key)
+    {
+        if (auto it = find_impl(key); it != end())
         {
-            if (k == key)
-                return v;
+            erase(it);
+            return;
         }
 
-        throw std::runtime_error{"Unexpected error"};
+        throw std::out_of_range("Key not found");
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    const Value& HashMap<Key, Value, HashFunction>::at(const Key& key) const
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    template <typename K>
+    size_t HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::erase_impl(const K& key)
     {
-        size_t hashVal = hash_function(key);
-        
-        for (auto& [k, v] : m_Buckets[hashVal])
+        if (auto it = find_impl(key); it != end())
         {
-            if (k == key)
-                return v;
+            erase(it);
+            return 1;
         }
+        return 0;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::erase(const_iterator pos) -> iterator
+    {
+        iterator next(this, pos.m_Index, bucket_at(pos.m_Index).erase(pos.m_It));
+        next.skip_empty_buckets();
+        --m_NumElems;
+        return next;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::extract(const_iterator pos) -> node_type
+    {
+        Bucket& bucket = bucket_at(pos.m_Index);
+        node_type node{bucket};
+        node.m_Node.splice(node.m_Node.end(), bucket, pos.m_It);
+        --m_NumElems;
+        return node;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::extract(const Key& key) -> node_type
+    {
+        if (auto it = find_impl(key); it != end())
+            return extract(it);
+        return {};
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    auto HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::insert(node_type&& node) -> insert_return_type
+    {
+        if (node.empty())
+            return {end(), false, {}};
+
+        size_t hash = mixed_hash<HashFunction>(node.key());
+
+        if (auto it = find_impl(node.key(), hash); it != end())
+            return {it, false, std::move(node)};
+
+        // insert_node() splices the node out, leaving node empty
+        iterator it = insert_node(hash, node.m_Node);
+        return {it, true, {}};
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    template <typename K>
+    Value& HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::at_impl(const K& key)
+    {
+        if (auto it = find_impl(key); it != end())
+            return it->second;
 
         throw std::out_of_range{"Key not found"};
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    bool HashMap<Key, Value, HashFunction>::empty() const noexcept
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    bool HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::empty() const noexcept
     {
         return m_NumElems == 0;
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    size_t HashMap<Key, Value, HashFunction>::size() const noexcept
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    size_t HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::size() const noexcept
     {
         return m_NumElems;
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    double HashMap<Key, Value, HashFunction>::load_factor() const noexcept
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator>
+    double HashMap<Key, Value, HashFunction, KeyEqual, Allocator>::load_factor() const noexcept
     {
         return static_cast<double>(m_NumElems) / m_Buckets.size();
     }
 
-}
\ No newline at end of file
+    namespace pmr
+    {
+        template <typename Key, typename Value, typename HashFunction = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+        using HashMap = pysojic::HashMap<Key, Value, HashFunction, KeyEqual, std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
+    }
+}
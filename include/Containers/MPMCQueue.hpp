@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Bounded lock-free queue for several producers and/or several consumers (Dmitry Vyukov's bounded MPMC queue,
+// see https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue and rigtorp/MPMCQueue).
+//
+// Every slot carries a sequence number telling whose turn it is:
+//   - seq == pos:                the slot is free for the producer that claims position pos
+//   - seq == pos + 1:            it holds the element pushed at pos, ready for the consumer that claims pos
+//   - seq == pos + Capacity:     the consumer is done, free for the producer of the next lap
+// A producer claims a position by bumping m_Head with a CAS, builds the element in the slot and then publishes it
+// by storing seq = pos + 1 (release). Consumers do the same with m_Tail. Producers only contend with each other on
+// m_Head and consumers on m_Tail, and a producer and a consumer only meet on the slot they exchange.
+//
+// With a single producer (MultiProducer = false) nobody else can move m_Head, so the CAS loop becomes a plain
+// load/store; same for a single consumer and m_Tail. MPSCQueue (fan-in of several threads to one) and SPMCQueue
+// (fan-out) below only pay for the side that is shared.
+//
+// Slots are not padded to a cache line each: two producers publishing neighbouring positions may share a line for
+// a moment, in exchange for a ring 8 times smaller with 8-byte elements.
+namespace pysojic
+{
+    template <typename T, std::size_t Capacity, bool MultiProducer = true, bool MultiConsumer = true>
+    class MPMCQueue
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be >= 2 and a power of two");
+        // A slot claimed by a producer/consumer cannot be given back, so what happens after the claim must not throw
+        static_assert(std::is_nothrow_move_constructible_v<T>, "T must be nothrow move constructible");
+        static_assert(std::is_nothrow_destructible_v<T>, "T must be nothrow destructible");
+
+        static constexpr std::size_t CACHE_LINE = 64;
+
+        struct Slot
+        {
+            std::atomic<std::size_t> seq;
+            alignas(T) std::byte storage[sizeof(T)];
+
+            T* element() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+        };
+
+    public:
+        MPMCQueue() noexcept;
+        ~MPMCQueue();
+
+        // no copies or moves
+        MPMCQueue(const MPMCQueue&) = delete;
+        MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+        /// Construct an element from args, returns false (and constructs nothing) if the queue is full.
+        /// If T's constructor can throw, the element is built before claiming a slot and then moved in.
+        template <typename... Args>
+        bool emplace(Args&&... args);
+        bool push(const T& value) { return emplace(value); }
+        bool push(T&& value) noexcept { return emplace(std::move(value)); }
+
+        /// Move the oldest element into out and remove it, returns false if the queue is empty
+        bool pop(T& out) noexcept;
+
+        // Snapshots: with other threads pushing/popping, the result may be stale by the time it is returned
+        std::size_t size() const noexcept;
+        bool empty() const noexcept { return size() == 0; }
+        bool full() const noexcept { return size() >= Capacity; }
+        static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+    private:
+        Slot& slot(std::size_t pos) noexcept { return m_Slots[pos & (Capacity - 1)]; }
+
+        // Claim the position of the next free slot for a producer, false if the queue is full
+        bool claim_head(std::size_t& pos) noexcept;
+        // Claim the position of the next published element for a consumer, false if the queue is empty
+        bool claim_tail(std::size_t& pos) noexcept;
+
+    private:
+        alignas(CACHE_LINE) Slot m_Slots[Capacity];
+        // Next position to push, shared by the producers
+        alignas(CACHE_LINE) std::atomic<std::size_t> m_Head{0};
+        // Next position to pop, shared by the consumers
+        alignas(CACHE_LINE) std::atomic<std::size_t> m_Tail{0};
+    };
+
+    template <typename T, std::size_t Capacity>
+    using MPSCQueue = MPMCQueue<T, Capacity, true, false>;
+    template <typename T, std::size_t Capacity>
+    using SPMCQueue = MPMCQueue<T, Capacity, false, true>;
+
+    //------------ Implementation ------------
+
+    template <typename T, std::size_t Capacity, bool MultiProducer, bool MultiConsumer>
+    MPMCQueue<T, Capacity, MultiProducer, MultiConsumer>::MPMCQueue() noexcept
+    {
+        for (std::size_t i = 0; i < Capacity; ++i)
+            m_Slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    template <typename T, std::size_t Capacity, bool MultiProducer, bool MultiConsumer>
+    MPMCQueue<T, Capacity, MultiProducer, MultiConsumer>::~MPMCQueue()
+    {
+        std::size_t head = m_Head.load(std::memory_order_relaxed);
+        for (std::size_t pos = m_Tail.load(std::memory_order_relaxed); pos != head; ++pos)
+            slot(pos).element()->~T();
+    }
+
+    template <typename T, std::size_t Capacity, bool MultiProducer, bool MultiConsumer>
+    bool MPMCQueue<T, Capacity, MultiProducer, MultiConsumer>::claim_head(std::size_t& pos) noexcept
+    {
+        pos = m_Head.load(std::memory_order_relaxed);
+        if constexpr (!MultiProducer)
+        {
+            // The slot is still in use by the consumer of the previous lap: full
+            if (slot(pos).seq.load(std::memory_order_acquire) != pos)
+                return false;
+            m_Head.store(pos + 1, std::memory_order_relaxed);
+            return true;
+        }
+        else
+        {
+            for (;;)
+            {
+                std::size_t seq = slot(pos).seq.load(std::memory_order_acquire);
+                auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+                if (diff == 0)
+                {
+                    // Free for position pos: try to be the producer that gets it (on failure pos is reloaded)
+                    if (m_Head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        return true;
+                }
+                else if (diff < 0)
+                {
+                    return false; // not consumed yet since the last lap
+                }
+                else
+                {
+                    pos = m_Head.load(std::memory_order_relaxed); // another producer took pos already
+                }
+            }
+        }
+    }
+
+    template <typename T, std::size_t Capacity, bool MultiProducer, bool MultiConsumer>
+    bool MPMCQueue<T, Capacity, MultiProducer, MultiConsumer>::claim_tail(std::size_t& pos) noexcept
+    {
+        pos = m_Tail.load(std::memory_order_relaxed);
+        if constexpr (!MultiConsumer)
+        {
+            // Nothing published at pos yet: empty
+            if (slot(pos).seq.load(std::memory_order_acquire) != pos + 1)
+                return false;
+            m_Tail.store(pos + 1, std::memory_order_relaxed);
+            return true;
+        }
+        else
+        {
+            for (;;)
+            {
+                std::size_t seq = slot(pos).seq.load(std::memory_order_acquire);
+                auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+                if (diff == 0)
+                {
+                    if (m_Tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        return true;
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = m_Tail.load(std::memory_order_relaxed); // another consumer took pos already
+                }
+            }
+        }
+    }
+
+    template <typename T, std::size_t Capacity, bool MultiProducer, bool MultiConsumer>
+    template <typename... Args>
+    bool MPMCQueue<T, Capacity, MultiProducer, MultiConsumer>::emplace(Args&&... args)
+    {
+        if constexpr (!std::is_nothrow_constructible_v<T, Args&&...>)
+        {
+            // Whatever can throw happens before the claim
+            T value(std::forward<Args>(args)...);
+            return emplace(std::move(value));
+        }
+        else
+        {
+            std::size_t pos;
+            if (!claim_head(pos))
+                return false;
+
+            Slot& s = slot(pos);
+            ::new (static_cast<void*>(s.storage)) T(std::forward<Args>(args)...);
+            s.seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+    }
+
+    template <typename T, std::size_t Capacity, bool MultiProducer, bool MultiConsumer>
+    bool MPMCQueue<T, Capacity, MultiProducer, MultiConsumer>::pop(T& out) noexcept
+    {
+        static_assert(std::is_nothrow_move_assignable_v<T>, "T must be nothrow move assignable to be popped");
+
+        std::size_t pos;
+        if (!claim_tail(pos))
+            return false;
+
+        Slot& s = slot(pos);
+        T* elem = s.element();
+        out = std::move(*elem);
+        elem->~T();
+        // Hand the slot to the producer of the next lap
+        s.seq.store(pos + Capacity, std::memory_order_release);
+        return true;
+    }
+
+    template <typename T, std::size_t Capacity, bool MultiProducer, bool MultiConsumer>
+    std::size_t MPMCQueue<T, Capacity, MultiProducer, MultiConsumer>::size() const noexcept
+    {
+        // Tail first: the head read afterwards can only be further ahead, so the difference never goes negative.
+        // It can exceed Capacity though: producers may have pushed more (after consumers freed slots) between the
+        // two loads, hence the clamp.
+        std::size_t tail = m_Tail.load(std::memory_order_acquire);
+        std::size_t head = m_Head.load(std::memory_order_acquire);
+        return std::min(head - tail, Capacity);
+    }
+}
@@ -0,0 +1,465 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <random>
+#endif
+
+#include "Containers/OpenAddressingHashMap.hpp"
+#include "Utilities/Hash.hpp"
+
+// Read-only hash map over a flat snapshot image, see save()/open().
+//
+// Rebuilding a big lookup table at startup by inserting every element costs minutes (hashing, probing, page faults
+// of a table growing several times). Instead, save() writes an OpenAddressingHashMap of trivially copyable keys and
+// values as a ready-to-probe table, and open() mmaps the file: there is no deserialization at all, a lookup probes
+// the mapped arrays directly, and the kernel only reads the pages that lookups actually touch (use populate = true
+// to read everything up front instead). Several processes opening the same file share its pages in the page cache.
+// The only part read in full by open() is the states array (1 byte per slot), which is validated before any probing.
+//
+// Image layout (native endianness, every array starts on a 64-byte boundary):
+//   Header | states (1 byte per slot) | keys | values
+// It is always the struct-of-arrays layout with linear probing, whatever the layout of the map it came from,
+// and has no tombstones: save() reinserts the elements into a fresh table with a load factor of at most 0.8.
+//
+// The hash must give the same result in the process that wrote the image and in the one reading it: std::hash of
+// integers does (identity/fmix64, see mixed_hash), as do the policies of Utilities/Hash.hpp; std::hash of other types
+// is only guaranteed to be stable within one run. The header records sizeof/alignof of Key/Value, the endianness
+// and the hash of a value-initialized key, and open() also looks up a sample of the stored keys: an image written
+// for other types or with another hash function is refused instead of silently missing keys.
+namespace pysojic
+{
+    namespace snapshot_detail
+    {
+        inline constexpr char MAGIC[8] = {'P', 'Y', 'S', 'O', 'J', 'O', 'A', 'H'};
+        inline constexpr std::uint32_t VERSION = 1;
+        // Reads back as 0x04030201 on a machine of the other endianness
+        inline constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+        inline constexpr std::uint64_t ALIGNMENT = 64;
+
+        struct Header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byte_order;
+            std::uint64_t key_size;
+            std::uint64_t key_align;
+            std::uint64_t value_size;
+            std::uint64_t value_align;
+            std::uint64_t hash_check;
+            std::uint64_t capacity;
+            std::uint64_t size;
+            std::uint64_t states_offset;
+            std::uint64_t keys_offset;
+            std::uint64_t values_offset;
+            std::uint64_t file_size;
+        };
+
+        constexpr std::uint64_t align_up(std::uint64_t offset) noexcept
+        {
+            return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        }
+
+        // Name for the file save() writes before renaming it over path, unique to the process and the call so that
+        // concurrent saves to the same path never write into the same file
+        inline std::string temp_path(const std::string& path)
+        {
+            static std::atomic<std::uint64_t> counter{0};
+#if defined(__unix__) || defined(__APPLE__)
+            auto process = static_cast<std::uint64_t>(::getpid());
+#else
+            static const std::uint64_t process = std::random_device{}();
+#endif
+            return path + ".tmp." + std::to_string(process) + "." + std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+        }
+
+        struct AlignedDelete
+        {
+            void operator()(std::byte* ptr) const noexcept { ::operator delete(ptr, std::align_val_t{ALIGNMENT}); }
+        };
+
+        // Read-only view of a whole file, unmapped/freed on destruction
+        class FileImage
+        {
+        public:
+            FileImage() = default;
+            FileImage(const std::string& path, bool populate);
+            ~FileImage() { release(); }
+
+            FileImage(FileImage&& other) noexcept
+                : m_Data{std::exchange(other.m_Data, nullptr)}, m_Size{std::exchange(other.m_Size, 0)}, m_Heap{std::move(other.m_Heap)}
+            {}
+            FileImage& operator=(FileImage&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    release();
+                    m_Data = std::exchange(other.m_Data, nullptr);
+                    m_Size = std::exchange(other.m_Size, 0);
+                    m_Heap = std::move(other.m_Heap);
+                }
+                return *this;
+            }
+
+            std::span<const std::byte> bytes() const noexcept { return {m_Data, m_Size}; }
+
+        private:
+            void release() noexcept;
+
+        private:
+            const std::byte* m_Data = nullptr;
+            size_t m_Size = 0;
+            // Without mmap the file is read into memory (64-byte aligned, like a mapping would be)
+            std::unique_ptr<std::byte, AlignedDelete> m_Heap;
+        };
+
+#if defined(__unix__) || defined(__APPLE__)
+        inline FileImage::FileImage(const std::string& path, bool populate)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("MappedHashMap: cannot open " + path);
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || st.st_size == 0)
+            {
+                ::close(fd);
+                throw std::runtime_error("MappedHashMap: cannot read " + path);
+            }
+
+            int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+            if (populate)
+                flags |= MAP_POPULATE;
+#endif
+            void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, flags, fd, 0);
+            ::close(fd); // the mapping keeps the file alive
+            if (addr == MAP_FAILED)
+                throw std::runtime_error("MappedHashMap: cannot map " + path);
+
+            m_Data = static_cast<const std::byte*>(addr);
+            m_Size = static_cast<size_t>(st.st_size);
+            // Lookups jump around the table, readahead would mostly load pages nobody asks for
+            if (!populate)
+                ::madvise(addr, m_Size, MADV_RANDOM);
+        }
+
+        inline void FileImage::release() noexcept
+        {
+            if (m_Data && !m_Heap)
+                ::munmap(const_cast<std::byte*>(m_Data), m_Size);
+            m_Data = nullptr;
+            m_Heap.reset();
+        }
+#else
+        inline FileImage::FileImage(const std::string& path, bool)
+        {
+            std::ifstream in(path, std::ios::binary | std::ios::ate);
+            if (!in)
+                throw std::runtime_error("MappedHashMap: cannot open " + path);
+            m_Size = static_cast<size_t>(in.tellg());
+            m_Heap.reset(static_cast<std::byte*>(::operator new(m_Size, std::align_val_t{ALIGNMENT})));
+            in.seekg(0);
+            if (!in.read(reinterpret_cast<char*>(m_Heap.get()), static_cast<std::streamsize>(m_Size)))
+                throw std::runtime_error("MappedHashMap: cannot read " + path);
+            m_Data = m_Heap.get();
+        }
+
+        inline void FileImage::release() noexcept
+        {
+            m_Data = nullptr;
+            m_Heap.reset();
+        }
+#endif
+    }
+
+    template <typename Key, typename Value, typename HashFunction = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class MappedHashMap
+    {
+        static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>,
+                      "Only trivially copyable keys and values can be stored as raw bytes");
+        static_assert(alignof(Key) <= snapshot_detail::ALIGNMENT && alignof(Value) <= snapshot_detail::ALIGNMENT,
+                      "Over-aligned keys/values are not supported");
+
+        using Header = snapshot_detail::Header;
+        using State = oa_layout::State;
+
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+
+        // Write map to path as a snapshot image. The file is written next to path and renamed over it once complete,
+        // so a process opening path never sees a half-written image.
+        template <typename Allocator, typename Layout>
+        static void save(const OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>& map,
+                         const std::string& path);
+
+        // Map the image at path. populate = true reads the whole file right away instead of on first access.
+        static MappedHashMap open(const std::string& path, bool populate = false);
+        // View an image that is already in memory, which must outlive the map and be aligned on 64 bytes
+        static MappedHashMap view(std::span<const std::byte> image);
+
+        MappedHashMap(MappedHashMap&&) noexcept = default;
+        MappedHashMap& operator=(MappedHashMap&&) noexcept = default;
+
+        // nullptr if key is absent
+        const Value* find(const Key& key) const { return find_impl(key); }
+        bool contains(const Key& key) const { return find_impl(key) != nullptr; }
+        const Value& at(const Key& key) const;
+
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        const Value* find(const K& key) const { return find_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        bool contains(const K& key) const { return find_impl(key) != nullptr; }
+
+        // Call f(const Key&, const Value&) on every element
+        template <typename F>
+        void visit_all(F&& f) const;
+
+        bool empty() const noexcept { return m_Size == 0; }
+        size_t size() const noexcept { return m_Size; }
+        size_t bucket_count() const noexcept { return m_Capacity; }
+
+    private:
+        MappedHashMap() = default;
+
+        static Header make_header(size_t capacity, size_t size);
+        void attach(std::span<const std::byte> image);
+
+        bool sample_lookups_succeed() const;
+
+        template <typename K>
+        const Value* find_impl(const K& key) const;
+
+    private:
+        snapshot_detail::FileImage m_File;
+        const State* m_States = nullptr;
+        const Key* m_Keys = nullptr;
+        const Value* m_Values = nullptr;
+        size_t m_Capacity = 0;
+        size_t m_Size = 0;
+    };
+
+    //------------ Implementation ------------
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    auto MappedHashMap<Key, Value, HashFunction, KeyEqual>::make_header(size_t capacity, size_t size) -> Header
+    {
+        Header header{};
+        std::memcpy(header.magic, snapshot_detail::MAGIC, sizeof(header.magic));
+        header.version = snapshot_detail::VERSION;
+        header.byte_order = snapshot_detail::BYTE_ORDER_MARK;
+        header.key_size = sizeof(Key);
+        header.key_align = alignof(Key);
+        header.value_size = sizeof(Value);
+        header.value_align = alignof(Value);
+        header.hash_check = mixed_hash<HashFunction>(Key{});
+        header.capacity = capacity;
+        header.size = size;
+        header.states_offset = snapshot_detail::align_up(sizeof(Header));
+        header.keys_offset = snapshot_detail::align_up(header.states_offset + capacity);
+        header.values_offset = snapshot_detail::align_up(header.keys_offset + capacity * sizeof(Key));
+        header.file_size = header.values_offset + capacity * sizeof(Value);
+        return header;
+    }
+
+    // Slots that stay EMPTY keep value-initialized keys/values so that saving the same map twice gives the same bytes
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    template <typename Allocator, typename Layout>
+    void MappedHashMap<Key, Value, HashFunction, KeyEqual>::save(
+        const OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>& map, const std::string& path)
+    {
+        // Max load factor 0.8, and always at least one EMPTY slot to end the probes
+        size_t capacity = std::max<size_t>(16, std::bit_ceil(map.size() + map.size() / 4 + 1));
+        std::vector<State> states(capacity, State::EMPTY);
+        std::vector<Key> keys(capacity);
+        std::vector<Value> values(capacity);
+
+        for (auto&& [key, value] : map)
+        {
+            size_t index = mixed_hash<HashFunction>(key) & (capacity - 1);
+            while (states[index] == State::OCCUPIED)
+                index = (index + 1) & (capacity - 1);
+            states[index] = State::OCCUPIED;
+            keys[index] = key;
+            values[index] = value;
+        }
+
+        Header header = make_header(capacity, map.size());
+        auto write_at = [](std::ofstream& out, std::uint64_t offset, const void* data, size_t bytes)
+        {
+            static constexpr char zeros[snapshot_detail::ALIGNMENT] = {};
+            out.write(zeros, static_cast<std::streamsize>(offset - static_cast<std::uint64_t>(out.tellp())));
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        };
+
+        std::string tmp_path = snapshot_detail::temp_path(path);
+        try
+        {
+            {
+                std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+                if (!out)
+                    throw std::runtime_error("MappedHashMap: cannot create " + tmp_path);
+                write_at(out, 0, &header, sizeof(header));
+                write_at(out, header.states_offset, states.data(), capacity);
+                write_at(out, header.keys_offset, keys.data(), capacity * sizeof(Key));
+                write_at(out, header.values_offset, values.data(), capacity * sizeof(Value));
+                if (!out.flush())
+                    throw std::runtime_error("MappedHashMap: cannot write " + tmp_path);
+            }
+            std::filesystem::rename(tmp_path, path);
+        }
+        catch (...)
+        {
+            // Don't leave a partial image behind
+            std::error_code ec;
+            std::filesystem::remove(tmp_path, ec);
+            throw;
+        }
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    auto MappedHashMap<Key, Value, HashFunction, KeyEqual>::open(const std::string& path, bool populate) -> MappedHashMap
+    {
+        MappedHashMap map;
+        map.m_File = snapshot_detail::FileImage(path, populate);
+        map.attach(map.m_File.bytes());
+        return map;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    auto MappedHashMap<Key, Value, HashFunction, KeyEqual>::view(std::span<const std::byte> image) -> MappedHashMap
+    {
+        MappedHashMap map;
+        map.attach(image);
+        return map;
+    }
+
+    // Check that the image was written for this Key/Value/HashFunction on this kind of machine and is complete,
+    // then point the arrays into it
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    void MappedHashMap<Key, Value, HashFunction, KeyEqual>::attach(std::span<const std::byte> image)
+    {
+        if (image.size() < sizeof(Header) || reinterpret_cast<std::uintptr_t>(image.data()) % snapshot_detail::ALIGNMENT != 0)
+            throw std::runtime_error("MappedHashMap: not a snapshot image");
+
+        Header header;
+        std::memcpy(&header, image.data(), sizeof(header));
+        if (std::memcmp(header.magic, snapshot_detail::MAGIC, sizeof(header.magic)) != 0)
+            throw std::runtime_error("MappedHashMap: not a snapshot image");
+        if (header.version != snapshot_detail::VERSION || header.byte_order != snapshot_detail::BYTE_ORDER_MARK)
+            throw std::runtime_error("MappedHashMap: unsupported snapshot version or byte order");
+
+        Header expected = make_header(header.capacity, header.size);
+        if (header.key_size != expected.key_size || header.key_align != expected.key_align ||
+            header.value_size != expected.value_size || header.value_align != expected.value_align)
+            throw std::runtime_error("MappedHashMap: snapshot was written for other key/value types");
+        if (header.hash_check != expected.hash_check)
+            throw std::runtime_error("MappedHashMap: snapshot was written with another hash function");
+        if (!std::has_single_bit(header.capacity) || header.size >= header.capacity ||
+            header.states_offset != expected.states_offset || header.keys_offset != expected.keys_offset ||
+            header.values_offset != expected.values_offset || header.file_size != expected.file_size ||
+            header.file_size > image.size())
+            throw std::runtime_error("MappedHashMap: corrupted or truncated snapshot");
+
+        // The probes stop at the first EMPTY slot and the sampling below looks for OCCUPIED ones: a states array with
+        // none of either (or garbage) would make them loop forever. Every byte must be a valid state (no tombstones
+        // in an image) and the OCCUPIED ones must add up to size, which is below capacity, so an EMPTY slot exists.
+        const auto* states = reinterpret_cast<const std::uint8_t*>(image.data() + header.states_offset);
+        size_t occupied = 0;
+        for (size_t i = 0; i < header.capacity; ++i)
+        {
+            if (states[i] == static_cast<std::uint8_t>(State::OCCUPIED))
+                ++occupied;
+            else if (states[i] != static_cast<std::uint8_t>(State::EMPTY))
+                throw std::runtime_error("MappedHashMap: corrupted or truncated snapshot");
+        }
+        if (occupied != header.size)
+            throw std::runtime_error("MappedHashMap: corrupted or truncated snapshot");
+
+        m_States = reinterpret_cast<const State*>(image.data() + header.states_offset);
+        m_Keys = reinterpret_cast<const Key*>(image.data() + header.keys_offset);
+        m_Values = reinterpret_cast<const Value*>(image.data() + header.values_offset);
+        m_Capacity = header.capacity;
+        m_Size = header.size;
+
+        if (!sample_lookups_succeed())
+            throw std::runtime_error("MappedHashMap: snapshot was written with another hash function");
+    }
+
+    // Every stored key must be found at its own slot. Checking the first element after 64 evenly spaced positions
+    // only touches a few pages, and a different hash function fails it unless it happens to agree on all of them.
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    bool MappedHashMap<Key, Value, HashFunction, KeyEqual>::sample_lookups_succeed() const
+    {
+        constexpr size_t samples = 64;
+        for (size_t i = 0; i < samples && m_Size > 0; ++i)
+        {
+            size_t index = i * (m_Capacity / samples);
+            while (m_States[index] != State::OCCUPIED)
+                index = (index + 1) & (m_Capacity - 1);
+            if (find_impl(m_Keys[index]) != &m_Values[index])
+                return false;
+        }
+        return true;
+    }
+
+    // Same probing as OpenAddressingHashMap, minus the tombstones
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    template <typename K>
+    const Value* MappedHashMap<Key, Value, HashFunction, KeyEqual>::find_impl(const K& key) const
+    {
+        if (m_Capacity == 0)
+            return nullptr;
+
+        size_t index = mixed_hash<HashFunction>(key) & (m_Capacity - 1);
+        while (m_States[index] == State::OCCUPIED)
+        {
+            if (KeyEqual{}(m_Keys[index], key))
+                return &m_Values[index];
+            index = (index + 1) & (m_Capacity - 1);
+        }
+        return nullptr;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    const Value& MappedHashMap<Key, Value, HashFunction, KeyEqual>::at(const Key& key) const
+    {
+        if (const Value* value = find_impl(key))
+            return *value;
+        throw std::out_of_range("Key not found");
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    template <typename F>
+    void MappedHashMap<Key, Value, HashFunction, KeyEqual>::visit_all(F&& f) const
+    {
+        for (size_t i = 0; i < m_Capacity; ++i)
+        {
+            if (m_States[i] == State::OCCUPIED)
+                std::invoke(f, m_Keys[i], m_Values[i]);
+        }
+    }
+}
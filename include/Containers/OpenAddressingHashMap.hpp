@@ -2,9 +2,22 @@
 
 #include <tuple>
 #include <vector>
+#include <iterator>
 #include <stdexcept>
 #include <climits>
 #include <optional>
+#include <functional>
+#include <utility>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <bit>
+
+#include "Utilities/Hash.hpp"
+#include "Utilities/Prefetch.hpp"
 
 // See Rigtorp implementation for a more complete/fine-tuned impl at https://github.com/rigtorp/HashMap
 
@@ -13,206 +26,846 @@
 static_assert((INITIAL_BUCKET_COUNT & (INITIAL_BUCKET_COUNT - 1)) == 0, "BUCKET_COUNT should be a power of 2!");
 
 // The following uses linear probing
+//
+// Incremental rehashing (set_incremental_rehash(true)):
+// instead of moving every entry inside the insert that crosses the max load factor, that insert only allocates the
+// bigger table and keeps the old one alongside it. Every following insertion moves the next few old slots over,
+// leaving a DELETED marker behind so that probe chains in the old table stay intact. A key lives in exactly one of
+// the two tables: lookups probe the old table first (while it still holds elements) then the new one, and new keys
+// always go to the new table. Once the old table is empty it is released.
+// Allocating the new table is O(n) too (mostly page faults when its memory is first written), so it is built ahead
+// of time: past 3/4 of the max load factor, every insertion also appends a few EMPTY slots to it.
 namespace pysojic
 {
-    template <typename Key, typename Value, typename HashFunction = std::hash<Key>>
+    // Storage layouts of the slots. A layout provides a Table class template holding n slots, each with a state,
+    // a key and a value; the map only talks to the table through state()/key()/value() and friends.
+    namespace oa_layout
+    {
+        // One byte: a plain enum is int-sized, i.e. 3 bytes of padding per slot.
+        // OCCUPIED is the only odd value, which lets StructOfArrays find occupied slots 8 at a time.
+        enum class State : std::uint8_t
+        {
+            EMPTY,
+            OCCUPIED,
+            DELETED
+        };
+
+        // Key, value and state side by side in a single array (the classic layout).
+        // A hit brings the value into cache together with the key, but probing drags every value it passes along:
+        // with 8-byte keys and 64-byte values, a 64-byte cache line holds less than one slot.
+        struct ArrayOfStructs
+        {
+            template <typename Key, typename Value, typename Allocator>
+            class Table
+            {
+                struct Slot
+                {
+                    Key key_{};
+                    Value value_{};
+                    State state_ = State::EMPTY;
+                };
+                using SlotVector = std::vector<Slot, typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>>;
+
+            public:
+                explicit Table(const Allocator& alloc) : m_Slots(alloc) {}
+                Table(size_t count, const Allocator& alloc) : m_Slots(count, alloc) {}
+
+                size_t size() const noexcept { return m_Slots.size(); }
+                bool empty() const noexcept { return m_Slots.empty(); }
+                size_t capacity() const noexcept { return m_Slots.capacity(); }
+                void reserve(size_t count) { m_Slots.reserve(count); }
+                // New slots are EMPTY
+                void resize(size_t count) { m_Slots.resize(count); }
+                void swap(Table& other) noexcept { m_Slots.swap(other.m_Slots); }
+                Allocator get_allocator() const { return Allocator(m_Slots.get_allocator()); }
+
+                State state(size_t i) const noexcept { return m_Slots[i].state_; }
+                void set_state(size_t i, State state) noexcept { m_Slots[i].state_ = state; }
+                Key& key(size_t i) noexcept { return m_Slots[i].key_; }
+                const Key& key(size_t i) const noexcept { return m_Slots[i].key_; }
+                Value& value(size_t i) noexcept { return m_Slots[i].value_; }
+                const Value& value(size_t i) const noexcept { return m_Slots[i].value_; }
+
+                // Move the element of slot `from` of src into slot `to`, which becomes OCCUPIED
+                void move_slot(Table& src, size_t from, size_t to) { m_Slots[to] = std::move(src.m_Slots[from]); }
+                // Start loading what a probe of slot i reads
+                void prefetch(size_t i) const noexcept { prefetch_read(&m_Slots[i]); }
+                // First OCCUPIED slot at or after i, or size()
+                size_t next_occupied(size_t i) const noexcept
+                {
+                    while (i < m_Slots.size() && m_Slots[i].state_ != State::OCCUPIED)
+                        ++i;
+                    return i;
+                }
+
+            private:
+                SlotVector m_Slots;
+            };
+        };
+
+        // States, keys and values in three parallel arrays. A probe only reads the states and the keys
+        // (64 states and 8 8-byte keys per cache line, whatever the size of the values), and the value array is
+        // touched once, on a hit. Iteration and rehashing scan the dense state array.
+        struct StructOfArrays
+        {
+            template <typename Key, typename Value, typename Allocator>
+            class Table
+            {
+                template <typename T>
+                using Array = std::vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>;
+
+            public:
+                explicit Table(const Allocator& alloc) : m_States(alloc), m_Keys(alloc), m_Values(alloc) {}
+                Table(size_t count, const Allocator& alloc)
+                    : m_States(count, State::EMPTY, alloc), m_Keys(count, alloc), m_Values(count, alloc)
+                {}
+
+                size_t size() const noexcept { return m_States.size(); }
+                bool empty() const noexcept { return m_States.empty(); }
+                size_t capacity() const noexcept { return m_States.capacity(); }
+                void reserve(size_t count) { m_States.reserve(count); m_Keys.reserve(count); m_Values.reserve(count); }
+                // New slots are EMPTY
+                void resize(size_t count) { m_States.resize(count, State::EMPTY); m_Keys.resize(count); m_Values.resize(count); }
+                void swap(Table& other) noexcept
+                {
+                    m_States.swap(other.m_States);
+                    m_Keys.swap(other.m_Keys);
+                    m_Values.swap(other.m_Values);
+                }
+                Allocator get_allocator() const { return Allocator(m_States.get_allocator()); }
+
+                State state(size_t i) const noexcept { return m_States[i]; }
+                void set_state(size_t i, State state) noexcept { m_States[i] = state; }
+                Key& key(size_t i) noexcept { return m_Keys[i]; }
+                const Key& key(size_t i) const noexcept { return m_Keys[i]; }
+                Value& value(size_t i) noexcept { return m_Values[i]; }
+                const Value& value(size_t i) const noexcept { return m_Values[i]; }
+
+                // Move the element of slot `from` of src into slot `to`, which becomes OCCUPIED
+                void move_slot(Table& src, size_t from, size_t to)
+                {
+                    m_Keys[to] = std::move(src.m_Keys[from]);
+                    m_Values[to] = std::move(src.m_Values[from]);
+                    m_States[to] = State::OCCUPIED;
+                }
+                // Start loading what a probe of slot i reads
+                void prefetch(size_t i) const noexcept
+                {
+                    prefetch_read(&m_States[i]);
+                    prefetch_read(&m_Keys[i]);
+                }
+                // First OCCUPIED slot at or after i, or size().
+                // Reads 8 states per load: the low bit of each byte is set only for OCCUPIED slots, so masking the
+                // word with 0x01 in every byte leaves one bit per occupied slot, and the lowest one is the answer.
+                size_t next_occupied(size_t i) const noexcept
+                {
+                    constexpr std::uint64_t occupied_bits = 0x0101010101010101;
+                    for (; i + 8 <= m_States.size(); i += 8)
+                    {
+                        std::uint64_t word;
+                        std::memcpy(&word, &m_States[i], sizeof(word));
+                        if (std::uint64_t bits = word & occupied_bits)
+                        {
+                            if constexpr (std::endian::native == std::endian::little)
+                                return i + std::countr_zero(bits) / 8;
+                            else
+                                return i + std::countl_zero(bits) / 8;
+                        }
+                    }
+                    while (i < m_States.size() && m_States[i] != State::OCCUPIED)
+                        ++i;
+                    return i;
+                }
+
+            private:
+                Array<State> m_States;
+                Array<Key> m_Keys;
+                Array<Value> m_Values;
+            };
+        };
+    }
+
+    // Allocator is rebound to the slot type for the table(s). With a std::pmr::polymorphic_allocator
+    // (see pysojic::pmr::OpenAddressingHashMap below) the table lives in the given memory_resource, e.g. a
+    // monotonic_buffer_resource that releases everything at once.
+    // Layout is oa_layout::ArrayOfStructs (default) or oa_layout::StructOfArrays, see above.
+    template <typename Key, typename Value, typename HashFunction = std::hash<Key>, typename KeyEqual = std::equal_to<Key>,
+              typename Allocator = std::allocator<std::pair<Key, Value>>, typename Layout = oa_layout::ArrayOfStructs>
     class OpenAddressingHashMap
     {
         static_assert(std::is_default_constructible_v<Value>, "Value not default constructible!");
-        class Entry
+
+        using State = oa_layout::State;
+        using Table = typename Layout::template Table<Key, Value, Allocator>;
+
+        // Walks the slots in order, skipping the EMPTY/DELETED ones.
+        // Keys and values are handed out as a pair of references (like std::flat_map) rather than a pair&,
+        // so iterate with `for (auto&& [key, value] : map)` or `const auto&`.
+        template <bool IsConst>
+        class Iterator
         {
             friend class OpenAddressingHashMap;
+            template <bool> friend class Iterator;
+
+            using Map = std::conditional_t<IsConst, const OpenAddressingHashMap, OpenAddressingHashMap>;
+
         public:
-            enum class State
+            // reference is a prvalue proxy: a C++20 forward iterator, but only an input iterator to the C++17
+            // requirements (which want a real reference), same as std::flat_map
+            using iterator_category = std::input_iterator_tag;
+            using iterator_concept = std::forward_iterator_tag;
+            using value_type = std::pair<Key, Value>;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::pair<const Key&, std::conditional_t<IsConst, const Value&, Value&>>;
+
+            struct pointer
             {
-                EMPTY,
-                OCCUPIED,
-                DELETED
+                reference ref;
+                const reference* operator->() const noexcept { return &ref; }
             };
 
-            Entry()
-                : key_{}, value_{}, state_{State::EMPTY}
-            {}
-            Entry(const Key& key, const Value& val)
-                : key_{key}, value_{val}, state_{State::OCCUPIED}
+            Iterator() = default;
+            // iterator -> const_iterator
+            template <bool OtherConst> requires (IsConst && !OtherConst)
+            Iterator(const Iterator<OtherConst>& other)
+                : m_Map{other.m_Map}, m_Index{other.m_Index}
             {}
 
+            reference operator*() const { return {m_Map->key_at(m_Index), m_Map->value_at(m_Index)}; }
+            pointer operator->() const { return {**this}; }
+            Iterator& operator++() { ++m_Index; skip_free_slots(); return *this; }
+            Iterator operator++(int) { Iterator tmp = *this; ++*this; return tmp; }
+            bool operator==(const Iterator& other) const { return m_Index == other.m_Index; }
+
+        private:
+            Iterator(Map* map, size_t index)
+                : m_Map{map}, m_Index{index}
+            {
+                skip_free_slots();
+            }
+
+            void skip_free_slots() { m_Index = m_Map->next_occupied(m_Index); }
+
         private:
-            Key key_;
-            Value value_;
-            State state_ = State::EMPTY;
+            Map* m_Map = nullptr;
+            size_t m_Index = 0;
         };
 
     public:
-        OpenAddressingHashMap();
+        using key_type = Key;
+        using mapped_type = Value;
+        using value_type = std::pair<Key, Value>;
+        using allocator_type = Allocator;
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        // An element extracted from the map (or nothing), see extract()/insert(NodeHandle&&).
+        // The key can be modified before the node is inserted back, into this map or another one.
+        class NodeHandle
+        {
+            friend class OpenAddressingHashMap;
+        public:
+            NodeHandle() = default;
+
+            bool empty() const noexcept { return !m_Elem.has_value(); }
+            explicit operator bool() const noexcept { return m_Elem.has_value(); }
+            Key& key() { return m_Elem->first; }
+            Value& mapped() { return m_Elem->second; }
+
+        private:
+            explicit NodeHandle(std::pair<Key, Value>&& elem) : m_Elem{std::move(elem)} {}
+
+        private:
+            std::optional<std::pair<Key, Value>> m_Elem;
+        };
+        using node_type = NodeHandle;
+
+        struct InsertReturn
+        {
+            iterator position;
+            bool inserted;
+            node_type node; // the node given to insert() if the key was already there, empty otherwise
+        };
+        using insert_return_type = InsertReturn;
+
+        OpenAddressingHashMap() : OpenAddressingHashMap(Allocator{}) {}
+        explicit OpenAddressingHashMap(const Allocator& alloc);
 
         void insert(const Key& key, const Value& val);
-        void remove(const Key& key);
-        Value& operator[](const Key& key);
+        void remove(const Key& key) { remove_impl(key); }
+        Value& operator[](const Key& key) { return *slot_value(try_emplace_impl(key).first); }
+        Value& operator[](Key&& key) { return *slot_value(try_emplace_impl(std::move(key)).first); }
         void rehash(size_t new_size);
 
+        // Insert or overwrite, moving the key/value in when given rvalues
+        template <typename M>
+        std::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) { return to_iterator(insert_or_assign_impl(key, std::forward<M>(obj))); }
+        template <typename M>
+        std::pair<iterator, bool> insert_or_assign(Key&& key, M&& obj) { return to_iterator(insert_or_assign_impl(std::move(key), std::forward<M>(obj))); }
+        // The value is only constructed if the key is absent
+        template <typename... Args>
+        std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) { return to_iterator(try_emplace_impl(key, std::forward<Args>(args)...)); }
+        template <typename... Args>
+        std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) { return to_iterator(try_emplace_impl(std::move(key), std::forward<Args>(args)...)); }
+        template <typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args);
+
+        // Unlike remove(), erasing an absent key is not an error: returns the number of elements erased (0 or 1)
+        size_t erase(const Key& key) { return erase_impl(key); }
+        // Returns the iterator following pos. Other iterators stay valid: erasing never moves elements.
+        iterator erase(const_iterator pos);
+        iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+        // Move the element out of the map (an empty node if key is absent)
+        node_type extract(const_iterator pos);
+        node_type extract(const Key& key);
+        // Insert the element of node if its key is absent. Otherwise the node is handed back in the result.
+        insert_return_type insert(node_type&& node);
+
+        Value& at(const Key& key) { return at_impl(key); }
+        const Value& at(const Key& key) const { return const_cast<OpenAddressingHashMap&>(*this).at_impl(key); }
+        iterator find(const Key& key) { return iterator(this, find_index(key)); }
+        const_iterator find(const Key& key) const { return const_iterator(this, find_index(key)); }
+        bool contains(const Key& key) const { return find_index(key) != slot_count(); }
+
+        // Batched lookup: out[i] = find(keys[i]). On tables that do not fit in cache, every find() is a cache miss
+        // the CPU waits for; here the keys are hashed and their slots prefetched a chunk at a time before any of them
+        // is probed, so the misses of a chunk overlap instead of being paid one after the other.
+        void find_batch(std::span<const Key> keys, std::span<iterator> out);
+        void find_batch(std::span<const Key> keys, std::span<const_iterator> out) const;
+
+        // Heterogeneous lookup (e.g. std::string keys queried with a std::string_view or a const char*),
+        // enabled when both HashFunction and KeyEqual are transparent, see Utilities/Hash.hpp
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        void remove(const K& key) { remove_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        size_t erase(const K& key) { return erase_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        Value& operator[](K&& key) { return *slot_value(try_emplace_impl(std::forward<K>(key)).first); }
+        template <typename K, typename M> requires TransparentHash<HashFunction, KeyEqual>
+        std::pair<iterator, bool> insert_or_assign(K&& key, M&& obj) { return to_iterator(insert_or_assign_impl(std::forward<K>(key), std::forward<M>(obj))); }
+        template <typename K, typename... Args> requires TransparentHash<HashFunction, KeyEqual>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) { return to_iterator(try_emplace_impl(std::forward<K>(key), std::forward<Args>(args)...)); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        Value& at(const K& key) { return at_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        const Value& at(const K& key) const { return const_cast<OpenAddressingHashMap&>(*this).at_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        iterator find(const K& key) { return iterator(this, find_index(key)); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        const_iterator find(const K& key) const { return const_iterator(this, find_index(key)); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        bool contains(const K& key) const { return find_index(key) != slot_count(); }
+
+        iterator begin() { return iterator(this, 0); }
+        const_iterator begin() const { return const_iterator(this, 0); }
+        iterator end() { return iterator(this, slot_count()); }
+        const_iterator end() const { return const_iterator(this, slot_count()); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        bool empty() const noexcept { return m_NumElems == 0; }
+        size_t size() const noexcept { return m_NumElems; }
         size_t bucket_count() const noexcept { return m_Arr.size(); }
         double load_factor() const noexcept { return static_cast<double>(m_NumElems) / m_Arr.size(); }
+        allocator_type get_allocator() const { return allocator_type(m_Arr.get_allocator()); }
+
+        // Spread the cost of growing over the following insertions instead of paying it in one go.
+        // Turning it off finishes any migration in progress.
+        void set_incremental_rehash(bool enabled);
+        bool incremental_rehash() const noexcept { return m_IncrementalRehash; }
+        bool rehash_in_progress() const noexcept { return !m_OldArr.empty(); }
 
     private:
-        size_t hash_function(const Key& key) const;
-        size_t hash_function(const Key& key, size_t table_size) const;
+        template <typename K>
+        size_t hash_function(const K& key) const;
+        template <typename K>
+        size_t hash_function(const K& key, size_t table_size) const;
+
+        // Slots are indexed as the old table (while migrating) followed by the current one.
+        // table_of() maps such an index to its table and turns it into an index in that table. The *_at() accessors
+        // used by lookups spell the same test out: going through table_of() keeps GCC from inlining them.
+        size_t slot_count() const noexcept { return m_OldArr.size() + m_Arr.size(); }
+        Table& table_of(size_t& index) noexcept;
+        const Key& key_at(size_t index) const noexcept { return index < m_OldArr.size() ? m_OldArr.key(index) : m_Arr.key(index - m_OldArr.size()); }
+        Value& value_at(size_t index) noexcept { return index < m_OldArr.size() ? m_OldArr.value(index) : m_Arr.value(index - m_OldArr.size()); }
+        const Value& value_at(size_t index) const noexcept { return index < m_OldArr.size() ? m_OldArr.value(index) : m_Arr.value(index - m_OldArr.size()); }
+        // First OCCUPIED slot at or after index, or slot_count()
+        size_t next_occupied(size_t index) const noexcept;
+
+        // Index of the slot of arr holding key, or arr.size() if absent
+        template <typename K>
+        static size_t probe(const Table& arr, size_t hash, const K& key);
+        // Index of the slot holding key, or slot_count() (i.e. the end() position) if absent
+        template <typename K>
+        size_t find_index(const K& key) const { return find_index(key, mixed_hash<HashFunction>(key)); }
+        template <typename K>
+        size_t find_index(const K& key, size_t hash) const;
+        // Calls emit(i, find_index(keys[i])) for every key
+        template <typename F>
+        void find_batch_impl(std::span<const Key> keys, F&& emit) const;
+        // Index of the slot holding key (second == true), or of the slot where it should be inserted
+        template <typename K>
+        std::pair<size_t, bool> find_or_prepare_insert(const K& key);
+        template <typename K, typename... Args>
+        void occupy(size_t index, K&& key, Args&&... args);
+        void grow();
+        void migrate(size_t slots);
+        void prepare_next_table();
+
+        Value* slot_value(size_t index) { return &value_at(index); }
+        std::pair<iterator, bool> to_iterator(std::pair<size_t, bool> res) { return {iterator(this, res.first), res.second}; }
+
+        template <typename K>
+        Value& at_impl(const K& key);
+        template <typename K>
+        void remove_impl(const K& key);
+        template <typename K>
+        size_t erase_impl(const K& key);
+        void erase_slot(size_t index);
+        template <typename K, typename... Args>
+        std::pair<size_t, bool> try_emplace_impl(K&& key, Args&&... args);
+        template <typename K, typename M>
+        std::pair<size_t, bool> insert_or_assign_impl(K&& key, M&& obj);
 
     private:
-        std::vector<Entry> m_Arr;
+        Table m_Arr;
         size_t m_NumElems;
         double m_MaxLoadFactor;
+
+        // Previous table while an incremental rehash is in progress: slots before m_MigrateIndex have been moved,
+        // m_OldNumElems elements are left in it
+        Table m_OldArr;
+        size_t m_MigrateIndex = 0;
+        size_t m_OldNumElems = 0;
+        // Table for the next growth, built a few slots at a time
+        Table m_NextArr;
+        bool m_IncrementalRehash = false;
+        // Old slots moved per insertion: the old table (n slots) must be drained before the new one (2n slots)
+        // goes from 0.4 to 0.8 load, i.e. within 0.8n insertions, so at least 2 per insertion
+        static constexpr size_t MIGRATION_STEP = 8;
+        // Next slots built per insertion: 2n of them between 0.6n and 0.8n elements, i.e. at least 10 per insertion
+        static constexpr size_t PREPARE_STEP = 16;
     };
 
     //------------ Implementation ------------
 
-    template <typename Key, typename Value, typename HashFunction>
-    size_t OpenAddressingHashMap<Key, Value, HashFunction>::hash_function(const Key& key) const
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename K>
+    size_t OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::hash_function(const K& key) const
     {
-        return HashFunction{}(key) & (m_Arr.size() - 1);
+        return mixed_hash<HashFunction>(key) & (m_Arr.size() - 1);
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    size_t OpenAddressingHashMap<Key, Value, HashFunction>::hash_function(const Key& key, size_t table_size) const
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename K>
+    size_t OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::hash_function(const K& key, size_t table_size) const
     {
-        return HashFunction{}(key) & (table_size - 1);
+        return mixed_hash<HashFunction>(key) & (table_size - 1);
     }
 
     // I use a power of two
-    template <typename Key, typename Value, typename HashFunction>
-    OpenAddressingHashMap<Key, Value, HashFunction>::OpenAddressingHashMap()
-        : m_Arr(INITIAL_BUCKET_COUNT), m_NumElems(0), m_MaxLoadFactor(0.8)
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::OpenAddressingHashMap(const Allocator& alloc)
+        : m_Arr(INITIAL_BUCKET_COUNT, alloc), m_NumElems(0), m_MaxLoadFactor(0.8), m_OldArr(alloc), m_NextArr(alloc)
     {
     }
 
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    auto OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::table_of(size_t& index) noexcept -> Table&
+    {
+        if (index < m_OldArr.size())
+            return m_OldArr;
+        index -= m_OldArr.size();
+        return m_Arr;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    size_t OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::next_occupied(size_t index) const noexcept
+    {
+        if (index < m_OldArr.size())
+        {
+            if (size_t found = m_OldArr.next_occupied(index); found != m_OldArr.size())
+                return found;
+            index = m_OldArr.size();
+        }
+        return m_OldArr.size() + m_Arr.next_occupied(index - m_OldArr.size());
+    }
+
     // Rehash: Create a new table of size new_size and reinsert all OCCUPIED entries
-    template <typename Key, typename Value, typename HashFunction>
-    void OpenAddressingHashMap<Key, Value, HashFunction>::rehash(size_t new_size)
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::rehash(size_t new_size)
     {
-        std::vector<Entry> new_arr(new_size);
+        migrate(m_OldArr.size());
+
+        Table new_arr(new_size, m_Arr.get_allocator());
 
         for (size_t i = 0; i < m_Arr.size(); ++i)
         {
-            if (m_Arr[i].state_ == Entry::State::OCCUPIED)
+            if (m_Arr.state(i) == State::OCCUPIED)
             {
-                size_t index = hash_function(m_Arr[i].key_, new_size);
-                while (new_arr[index].state_ == Entry::State::OCCUPIED)
+                size_t index = hash_function(m_Arr.key(i), new_size);
+                while (new_arr.state(index) == State::OCCUPIED)
                 {
                     index = (index + 1) & (new_size - 1);
                 }
-                new_arr[index] = std::move(m_Arr[i]);
+                new_arr.move_slot(m_Arr, i, index);
             }
         }
         m_Arr = std::move(new_arr);
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    void OpenAddressingHashMap<Key, Value, HashFunction>::insert(const Key& key, const Value& val)
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::grow()
     {
-        // Rehash if the load factor is exceeded
-        if (load_factor() >= m_MaxLoadFactor)
+        if (!m_IncrementalRehash)
         {
             rehash(m_Arr.size() * 2);
+            return;
         }
-        
-        size_t index = hash_function(key);
+
+        // Only possible if the previous migration was outpaced, finish it first
+        migrate(m_OldArr.size());
+
+        // Normally already done by prepare_next_table()
+        m_NextArr.resize(m_Arr.size() * 2);
+
+        m_OldArr = std::move(m_Arr);
+        m_Arr = std::move(m_NextArr);
+        m_NextArr = Table(m_Arr.get_allocator());
+        m_MigrateIndex = 0;
+        m_OldNumElems = m_NumElems;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::prepare_next_table()
+    {
+        if (load_factor() < 0.75 * m_MaxLoadFactor)
+            return;
+
+        size_t count = m_Arr.size() * 2;
+        if (m_NextArr.capacity() < count)
+            m_NextArr.reserve(count); // no memory is touched yet
+        if (m_NextArr.size() < count)
+            m_NextArr.resize(std::min(count, m_NextArr.size() + PREPARE_STEP));
+    }
+
+    // Move the OCCUPIED entries among the next `slots` old slots into the current table.
+    // The key cannot already be in the current table, so it goes to the first free slot of its probe sequence.
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::migrate(size_t slots)
+    {
+        for (; slots > 0 && m_OldNumElems > 0; --slots, ++m_MigrateIndex)
+        {
+            if (m_OldArr.state(m_MigrateIndex) != State::OCCUPIED)
+                continue;
+
+            size_t index = hash_function(m_OldArr.key(m_MigrateIndex));
+            while (m_Arr.state(index) == State::OCCUPIED)
+                index = (index + 1) & (m_Arr.size() - 1);
+
+            m_Arr.move_slot(m_OldArr, m_MigrateIndex, index);
+            m_OldArr.set_state(m_MigrateIndex, State::DELETED);
+            --m_OldNumElems;
+        }
+
+        if (m_OldNumElems == 0 && !m_OldArr.empty())
+        {
+            Table(m_Arr.get_allocator()).swap(m_OldArr);
+            m_MigrateIndex = 0;
+        }
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::set_incremental_rehash(bool enabled)
+    {
+        if (!enabled)
+        {
+            migrate(m_OldArr.size());
+            Table(m_Arr.get_allocator()).swap(m_NextArr);
+        }
+        m_IncrementalRehash = enabled;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename K>
+    size_t OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::probe(const Table& arr, size_t hash, const K& key)
+    {
+        const size_t mask = arr.size() - 1;
+        size_t index = hash & mask;
         size_t start = index;
-        std::optional<size_t> first_deleted; // an invalid index as a marker
 
-        while (true)
+        for (State state; (state = arr.state(index)) != State::EMPTY; )
         {
-            if (m_Arr[index].state_ == Entry::State::EMPTY)
-            {
-                // If we saw a deleted slot earlier, use that instead
-                if (first_deleted)
-                {
-                    index = first_deleted.value();
-                }
-                m_Arr[index] = Entry(key, val);
-                ++m_NumElems;
-                return;
-            }
-            else if (m_Arr[index].state_ == Entry::State::DELETED && !first_deleted)
-            {
-                first_deleted = index;
-            }
-            else if (m_Arr[index].state_ == Entry::State::OCCUPIED && m_Arr[index].key_ == key)
-            {
-                m_Arr[index].value_ = val;
-                return;
-            }
-            index = (index + 1) & (m_Arr.size() - 1);
+            if (state == State::OCCUPIED && KeyEqual{}(arr.key(index), key))
+                return index;
+
+            index = (index + 1) & mask;
+
             if (index == start)
+                break;
+        }
+        return mask + 1;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename K>
+    size_t OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::find_index(const K& key, size_t hash) const
+    {
+        if (m_OldNumElems > 0)
+        {
+            if (size_t index = probe(m_OldArr, hash, key); index != m_OldArr.size())
+                return index;
+        }
+
+        return m_OldArr.size() + probe(m_Arr, hash, key);
+    }
+
+    // Chunks of 16 keep the number of prefetches in flight around what a core can track (10-20 outstanding misses)
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename F>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::find_batch_impl(std::span<const Key> keys, F&& emit) const
+    {
+        constexpr size_t chunk = 16;
+        size_t hashes[chunk];
+
+        for (size_t first = 0; first < keys.size(); first += chunk)
+        {
+            size_t count = std::min(chunk, keys.size() - first);
+
+            for (size_t i = 0; i < count; ++i)
             {
-                // Should never happen because we rehash before full
-                throw std::runtime_error("HashMap is full, cannot insert");
+                hashes[i] = mixed_hash<HashFunction>(keys[first + i]);
+                m_Arr.prefetch(hashes[i] & (m_Arr.size() - 1));
+                if (m_OldNumElems > 0)
+                    m_OldArr.prefetch(hashes[i] & (m_OldArr.size() - 1));
             }
+
+            for (size_t i = 0; i < count; ++i)
+                emit(first + i, find_index(keys[first + i], hashes[i]));
         }
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    Value& OpenAddressingHashMap<Key, Value, HashFunction>::operator[](const Key& key)
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::find_batch(std::span<const Key> keys, std::span<iterator> out)
+    {
+        if (keys.size() != out.size())
+            throw std::invalid_argument("find_batch: keys and out must have the same size");
+        find_batch_impl(keys, [&](size_t i, size_t index) { out[i] = iterator(this, index); });
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::find_batch(std::span<const Key> keys, std::span<const_iterator> out) const
+    {
+        if (keys.size() != out.size())
+            throw std::invalid_argument("find_batch: keys and out must have the same size");
+        find_batch_impl(keys, [&](size_t i, size_t index) { out[i] = const_iterator(this, index); });
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename K>
+    std::pair<size_t, bool> OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::find_or_prepare_insert(const K& key)
     {
-        // Rehash if needed
+        // Rehash if the load factor is exceeded
         if (load_factor() >= m_MaxLoadFactor)
         {
-            rehash(m_Arr.size() * 2);
+            grow();
+        }
+        if (m_IncrementalRehash)
+        {
+            migrate(MIGRATION_STEP);
+            prepare_next_table();
+        }
+
+        size_t hash = mixed_hash<HashFunction>(key);
+        if (m_OldNumElems > 0)
+        {
+            if (size_t index = probe(m_OldArr, hash, key); index != m_OldArr.size())
+                return {index, true};
         }
-        
-        size_t index = hash_function(key);
+
+        // Slots of the current table come after the old ones
+        size_t offset = m_OldArr.size();
+        size_t index = hash & (m_Arr.size() - 1);
         size_t start = index;
-        std::optional<size_t> first_deleted;
+        std::optional<size_t> first_deleted; // an invalid index as a marker
 
         while (true)
         {
-            if (m_Arr[index].state_ == Entry::State::EMPTY)
+            if (m_Arr.state(index) == State::EMPTY)
             {
-                // Not found; insert new element
-                if (first_deleted)
-                {
-                    index = first_deleted.value();
-                }
-                m_Arr[index] = Entry(key, Value{}); // Default-constructed value
-                ++m_NumElems;
-                return m_Arr[index].value_;
+                // If we saw a deleted slot earlier, use that instead
+                return {offset + first_deleted.value_or(index), false};
             }
-            else if (m_Arr[index].state_ == Entry::State::DELETED && !first_deleted)
+            else if (m_Arr.state(index) == State::DELETED && !first_deleted)
             {
                 first_deleted = index;
             }
-            else if (m_Arr[index].state_ == Entry::State::OCCUPIED && m_Arr[index].key_ == key)
+            else if (m_Arr.state(index) == State::OCCUPIED && KeyEqual{}(m_Arr.key(index), key))
             {
-                return m_Arr[index].value_;
+                return {offset + index, true};
             }
             index = (index + 1) & (m_Arr.size() - 1);
             if (index == start)
             {
-                // Should never happen if rehashing is working correctly
-                throw std::runtime_error("HashMap is full");
+                // Every slot is either OCCUPIED or DELETED
+                if (first_deleted)
+                    return {offset + first_deleted.value(), false};
+                // Should never happen because we rehash before full
+                throw std::runtime_error("HashMap is full, cannot insert");
             }
         }
     }
 
-    template <typename Key, typename Value, typename HashFunction>
-    void OpenAddressingHashMap<Key, Value, HashFunction>::remove(const Key& key)
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename K, typename... Args>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::occupy(size_t index, K&& key, Args&&... args)
     {
-        size_t index = hash_function(key);
-        size_t start = index;
+        Table& table = table_of(index);
+        table.key(index) = Key(std::forward<K>(key));
+        table.value(index) = Value(std::forward<Args>(args)...);
+        table.set_state(index, State::OCCUPIED);
+        ++m_NumElems;
+    }
 
-        while (m_Arr[index].state_ != Entry::State::EMPTY)
-        {
-            if (m_Arr[index].state_ == Entry::State::OCCUPIED && m_Arr[index].key_ == key)
-            {
-                m_Arr[index].state_ = Entry::State::DELETED;
-                --m_NumElems;
-                return;
-            }
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::insert(const Key& key, const Value& val)
+    {
+        insert_or_assign_impl(key, val);
+    }
 
-            index = (index + 1) & (m_Arr.size() - 1);
-            
-            if (index == start)
-                break;
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename K, typename M>
+    std::pair<size_t, bool> OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::insert_or_assign_impl(K&& key, M&& obj)
+    {
+        auto [index, found] = find_or_prepare_insert(key);
+        if (found)
+        {
+            value_at(index) = std::forward<M>(obj);
+            return {index, false};
         }
-        throw std::out_of_range("Key not found");
+        occupy(index, std::forward<K>(key), std::forward<M>(obj));
+        return {index, true};
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename K, typename... Args>
+    std::pair<size_t, bool> OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::try_emplace_impl(K&& key, Args&&... args)
+    {
+        auto [index, found] = find_or_prepare_insert(key);
+        if (found)
+            return {index, false};
+
+        occupy(index, std::forward<K>(key), std::forward<Args>(args)...); // Default-constructed value if no args
+        return {index, true};
+    }
+
+    // The key is only known once the pair is built
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename... Args>
+    auto OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::emplace(Args&&... args) -> std::pair<iterator, bool>
+    {
+        std::pair<Key, Value> kv(std::forward<Args>(args)...);
+
+        auto [index, found] = find_or_prepare_insert(kv.first);
+        if (!found)
+            occupy(index, std::move(kv.first), std::move(kv.second));
+        return {iterator(this, index), !found};
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename K>
+    Value& OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::at_impl(const K& key)
+    {
+        size_t index = find_index(key);
+        if (index == slot_count())
+            throw std::out_of_range("Key not found");
+        return value_at(index);
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename K>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::remove_impl(const K& key)
+    {
+        size_t index = find_index(key);
+        if (index == slot_count())
+            throw std::out_of_range("Key not found");
+        erase_slot(index);
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    template <typename K>
+    size_t OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::erase_impl(const K& key)
+    {
+        size_t index = find_index(key);
+        if (index == slot_count())
+            return 0;
+        erase_slot(index);
+        return 1;
+    }
+
+    // The slot becomes a tombstone, its key/value are left as they are until the slot is reused
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    void OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::erase_slot(size_t index)
+    {
+        if (index < m_OldArr.size())
+            --m_OldNumElems;
+        --m_NumElems;
+
+        Table& table = table_of(index);
+        table.set_state(index, State::DELETED);
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    auto OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::erase(const_iterator pos) -> iterator
+    {
+        erase_slot(pos.m_Index);
+        return iterator(this, pos.m_Index + 1);
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    auto OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::extract(const_iterator pos) -> node_type
+    {
+        size_t index = pos.m_Index;
+        Table& table = table_of(index);
+        node_type node{{std::move(table.key(index)), std::move(table.value(index))}};
+        erase_slot(pos.m_Index);
+        return node;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    auto OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::extract(const Key& key) -> node_type
+    {
+        size_t index = find_index(key);
+        if (index == slot_count())
+            return {};
+        return extract(const_iterator(this, index));
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual, typename Allocator, typename Layout>
+    auto OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, Layout>::insert(node_type&& node) -> insert_return_type
+    {
+        if (node.empty())
+            return {end(), false, {}};
+
+        auto [index, found] = find_or_prepare_insert(node.key());
+        if (found)
+            return {iterator(this, index), false, std::move(node)};
+
+        occupy(index, std::move(node.key()), std::move(node.mapped()));
+        node.m_Elem.reset();
+        return {iterator(this, index), true, {}};
+    }
+
+    // Keys, values and states in separate arrays, see oa_layout::StructOfArrays
+    template <typename Key, typename Value, typename HashFunction = std::hash<Key>, typename KeyEqual = std::equal_to<Key>,
+              typename Allocator = std::allocator<std::pair<Key, Value>>>
+    using SoAOpenAddressingHashMap = OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual, Allocator, oa_layout::StructOfArrays>;
+
+    namespace pmr
+    {
+        template <typename Key, typename Value, typename HashFunction = std::hash<Key>, typename KeyEqual = std::equal_to<Key>,
+                  typename Layout = oa_layout::ArrayOfStructs>
+        using OpenAddressingHashMap = pysojic::OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual,
+                                                                     std::pmr::polymorphic_allocator<std::pair<Key, Value>>, Layout>;
     }
-}
\ No newline at end of file
+}
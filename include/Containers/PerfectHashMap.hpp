@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "Utilities/Hash.hpp"
+
+// Defined in Utilities/CompileTimeFunctions.hpp
+template <int... Args>
+struct CompileTimeVector;
+
+// Read-only map over a key set known at compile time, built by a constexpr perfect hash (CHD-style, "hash, displace
+// and compress", Belazzougui et al. 2009, with PTHash's xor-with-pilot placement):
+//   - The N keys are hashed once and split into about N/4 buckets by the high bits of their hash.
+//   - Buckets are placed from the largest to the smallest. For each one we search a pilot p (0, 1, 2...) such that
+//     every key of the bucket lands on a free slot, the slot being slot_of(hash(key) ^ fmix64(p)).
+//     Small buckets placed last have many free slots to choose from, which is why the big ones go first.
+//   - Only the pilots are kept (pre-mixed), one per bucket.
+// A lookup is then: hash, pick the bucket, xor its pilot, two multiplies/shifts to the slot and compare a single key.
+// No probing and no collision handling, and with a constexpr map the whole table is built by the compiler and lives
+// in read-only data: nothing runs at startup.
+//
+//   constexpr pysojic::PerfectHashMap codes{std::array{std::pair{'A', 1}, std::pair{'D', 2}, std::pair{'X', 3}}};
+//   static_assert(codes.at('D') == 2);
+//
+// The table has 1.25 N slots (load 0.8): the last buckets are placed while 20% of the slots are still free, which keeps
+// the pilot search short enough for the compiler (a thousand keys build within the default constexpr limits; for
+// more, raise -fconstexpr-ops-limit / -fconstexpr-steps).
+// The hash must be constexpr: the default is MurmurHash for integers/enums and WyHash for string-like keys.
+namespace pysojic
+{
+    namespace perfect_hash_detail
+    {
+        template <typename Key>
+        using DefaultHash = std::conditional_t<std::is_convertible_v<const Key&, std::string_view>, WyHash, MurmurHash>;
+
+        // Map the high 32 bits of x to [0, count) (Lemire's fast range reduction: a multiply instead of a modulo)
+        constexpr size_t fast_range(std::uint64_t x, size_t count) noexcept
+        {
+            return static_cast<size_t>(((x >> 32) * count) >> 32);
+        }
+
+        // Placement attempts per bucket before giving up (only two keys with the same 64-bit hash can get there)
+        inline constexpr std::uint32_t MAX_PILOT = 1u << 16;
+    }
+
+    template <typename Key, typename Value, size_t N, typename HashFunction = perfect_hash_detail::DefaultHash<Key>,
+              typename KeyEqual = std::equal_to<>>
+    class PerfectHashMap
+    {
+        static_assert(std::is_default_constructible_v<Key>, "Key not default constructible!");
+        static_assert(std::is_default_constructible_v<Value>, "Value not default constructible!");
+
+        static_assert(N < (size_t{1} << 31), "Too many keys");
+
+        static constexpr size_t SLOT_COUNT = N + N / 4 + 1;
+        // About 4 keys per bucket: fewer buckets means less memory for the pilots but longer searches
+        static constexpr size_t BUCKET_COUNT = N / 4 + 1;
+
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+        using value_type = std::pair<Key, Value>;
+
+        // Throws (i.e. fails to compile in a constant expression) on duplicate keys
+        constexpr explicit PerfectHashMap(const std::array<std::pair<Key, Value>, N>& entries);
+
+        // Same read API as HashMap, except that operator[] cannot insert: both throw std::out_of_range on a missing key
+        constexpr const Value& at(const Key& key) const { return at_impl(key); }
+        constexpr const Value& operator[](const Key& key) const { return at_impl(key); }
+        // nullptr if key is absent
+        constexpr const Value* find(const Key& key) const { return find_impl(key); }
+        constexpr bool contains(const Key& key) const { return find_impl(key) != nullptr; }
+
+        // Heterogeneous lookup, e.g. std::string_view keys queried with a const char*, see Utilities/Hash.hpp
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        constexpr const Value& at(const K& key) const { return at_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        constexpr const Value& operator[](const K& key) const { return at_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        constexpr const Value* find(const K& key) const { return find_impl(key); }
+        template <typename K> requires TransparentHash<HashFunction, KeyEqual>
+        constexpr bool contains(const K& key) const { return find_impl(key) != nullptr; }
+
+        static constexpr bool empty() noexcept { return N == 0; }
+        static constexpr size_t size() noexcept { return N; }
+        static constexpr size_t bucket_count() noexcept { return SLOT_COUNT; }
+
+    private:
+        static constexpr size_t bucket_of(std::uint64_t hash) noexcept
+        {
+            return perfect_hash_detail::fast_range(hash, BUCKET_COUNT);
+        }
+        // The multiply spreads every bit of hash ^ pilot into the high half that fast_range looks at
+        static constexpr size_t slot_of(std::uint64_t hash, std::uint64_t pilot) noexcept
+        {
+            return perfect_hash_detail::fast_range((hash ^ pilot) * 0x9E3779B97F4A7C15ULL, SLOT_COUNT);
+        }
+
+        template <typename K>
+        constexpr const Value* find_impl(const K& key) const;
+        template <typename K>
+        constexpr const Value& at_impl(const K& key) const;
+
+    private:
+        std::array<std::uint64_t, BUCKET_COUNT> m_Pilots{};
+        std::array<Key, SLOT_COUNT> m_Keys{};
+        std::array<Value, SLOT_COUNT> m_Values{};
+        std::array<bool, SLOT_COUNT> m_Used{};
+    };
+
+    //------------ Implementation ------------
+
+    template <typename Key, typename Value, size_t N, typename HashFunction, typename KeyEqual>
+    constexpr PerfectHashMap<Key, Value, N, HashFunction, KeyEqual>::PerfectHashMap(const std::array<std::pair<Key, Value>, N>& entries)
+    {
+        std::array<std::uint64_t, N> hashes{};
+        for (size_t i = 0; i < N; ++i)
+            hashes[i] = HashFunction{}(entries[i].first);
+
+        // Entries grouped by bucket (the bucket is a function of the hash, so sorting by hash does it), and buckets
+        // sorted by decreasing size. Equal keys have equal hashes and end up next to each other.
+        std::array<size_t, N> order{};
+        for (size_t i = 0; i < N; ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return hashes[a] < hashes[b]; });
+        for (size_t i = 1; i < N; ++i)
+        {
+            for (size_t j = i; j > 0 && hashes[order[j - 1]] == hashes[order[i]]; --j)
+            {
+                if (KeyEqual{}(entries[order[j - 1]].first, entries[order[i]].first))
+                    throw std::invalid_argument("PerfectHashMap: duplicate key");
+            }
+        }
+
+        std::array<size_t, BUCKET_COUNT + 1> first{}; // entries of bucket b are order[first[b], first[b + 1])
+        for (size_t i = 0; i < N; ++i)
+            ++first[bucket_of(hashes[i]) + 1];
+        for (size_t b = 0; b < BUCKET_COUNT; ++b)
+            first[b + 1] += first[b];
+
+        std::array<size_t, BUCKET_COUNT> buckets{};
+        for (size_t b = 0; b < BUCKET_COUNT; ++b)
+            buckets[b] = b;
+        // (std::stable_sort is not constexpr, ties are broken by index instead)
+        std::sort(buckets.begin(), buckets.end(), [&](size_t a, size_t b)
+        {
+            size_t size_a = first[a + 1] - first[a], size_b = first[b + 1] - first[b];
+            return size_a != size_b ? size_a > size_b : a < b;
+        });
+
+        for (size_t bucket : buckets)
+        {
+            size_t begin = first[bucket], end = first[bucket + 1];
+            if (begin == end)
+                break; // only empty buckets are left
+
+            for (std::uint32_t p = 0; ; ++p)
+            {
+                if (p == perfect_hash_detail::MAX_PILOT)
+                    throw std::runtime_error("PerfectHashMap: cannot place keys, two keys have the same hash");
+
+                std::uint64_t pilot = fmix64(p);
+                // Claim the slots one by one, and release them if one of the keys does not fit
+                size_t placed = begin;
+                for (; placed < end; ++placed)
+                {
+                    size_t slot = slot_of(hashes[order[placed]], pilot);
+                    if (m_Used[slot])
+                        break;
+                    m_Used[slot] = true;
+                }
+                if (placed == end)
+                {
+                    m_Pilots[bucket] = pilot;
+                    break;
+                }
+                for (size_t i = begin; i < placed; ++i)
+                    m_Used[slot_of(hashes[order[i]], pilot)] = false;
+            }
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                size_t slot = slot_of(hashes[order[i]], m_Pilots[bucket]);
+                m_Keys[slot] = entries[order[i]].first;
+                m_Values[slot] = entries[order[i]].second;
+            }
+        }
+    }
+
+    template <typename Key, typename Value, size_t N, typename HashFunction, typename KeyEqual>
+    template <typename K>
+    constexpr const Value* PerfectHashMap<Key, Value, N, HashFunction, KeyEqual>::find_impl(const K& key) const
+    {
+        std::uint64_t hash = HashFunction{}(key);
+        size_t slot = slot_of(hash, m_Pilots[bucket_of(hash)]);
+        if (m_Used[slot] && KeyEqual{}(m_Keys[slot], key))
+            return &m_Values[slot];
+        return nullptr;
+    }
+
+    template <typename Key, typename Value, size_t N, typename HashFunction, typename KeyEqual>
+    template <typename K>
+    constexpr const Value& PerfectHashMap<Key, Value, N, HashFunction, KeyEqual>::at_impl(const K& key) const
+    {
+        if (const Value* value = find_impl(key))
+            return *value;
+        throw std::out_of_range("Key not found");
+    }
+
+    // Build a map from a CompileTimeVector of keys and their values (in the same order):
+    //   constexpr auto ports = make_perfect_hash_map(CompileTimeVector<80, 443, 8080>{}, std::array{"http", "https", "alt"});
+    template <typename Value, int... Keys>
+    constexpr auto make_perfect_hash_map(CompileTimeVector<Keys...>, const std::array<Value, sizeof...(Keys)>& values)
+    {
+        constexpr std::array<int, sizeof...(Keys)> keys{Keys...};
+        std::array<std::pair<int, Value>, sizeof...(Keys)> entries{};
+        for (size_t i = 0; i < keys.size(); ++i)
+            entries[i] = {keys[i], values[i]};
+        return PerfectHashMap<int, Value, sizeof...(Keys)>(entries);
+    }
+}
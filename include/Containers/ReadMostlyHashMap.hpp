@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "Containers/OpenAddressingHashMap.hpp"
+#include "Concurrency/EpochReclamation.hpp"
+#include "Concurrency/Mutex.hpp"
+
+// Hash map for read-mostly workloads (many reader threads, a few writes per second).
+//
+// The current table is an immutable OpenAddressingHashMap published through an atomic pointer. Writers are serialized
+// by a lock and never touch the published table: they copy it, modify the copy and swap the pointer (copy-on-write).
+// The old table is retired to an EpochDomain and freed once no reader can still be looking at it.
+//
+// A lookup is: pin the epoch (a couple of plain stores/loads on the thread's own cache line and a fence),
+// load the table pointer, do a regular single-threaded OpenAddressingHashMap lookup, unpin.
+// No locks and no atomic read-modify-write on shared cache lines, so readers scale with the number of cores.
+// Writes cost O(n) (one full copy), use update() to batch several modifications into a single copy.
+namespace pysojic
+{
+    template <typename Key, typename Value, typename HashFunction = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class ReadMostlyHashMap
+    {
+    public:
+        using Table = OpenAddressingHashMap<Key, Value, HashFunction, KeyEqual>;
+
+        ReadMostlyHashMap();
+        ~ReadMostlyHashMap();
+
+        ReadMostlyHashMap(const ReadMostlyHashMap&) = delete;
+        ReadMostlyHashMap& operator=(const ReadMostlyHashMap&) = delete;
+
+        // Readers
+        std::optional<Value> find(const Key& key) const;
+        bool contains(const Key& key) const;
+        // Call f(const Value&) if key is present, the value stays valid for the duration of the call
+        template <typename F>
+        bool visit(const Key& key, F&& f) const;
+        size_t size() const;
+        bool empty() const { return size() == 0; }
+
+        // Writers
+        void insert(const Key& key, const Value& val);
+        bool erase(const Key& key);
+        // Apply f(Table&) to a private copy of the table and publish the result in one go
+        template <typename F>
+        void update(F&& f);
+
+    private:
+        void publish(Table* next);
+
+    private:
+        std::atomic<Table*> m_Table;
+        mutable EpochDomain m_Epochs;
+        Mutex m_WriteLock;
+    };
+
+    //------------ Implementation ------------
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    ReadMostlyHashMap<Key, Value, HashFunction, KeyEqual>::ReadMostlyHashMap()
+        : m_Table{new Table{}}
+    {}
+
+    // Retired tables are freed by m_Epochs' destructor
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    ReadMostlyHashMap<Key, Value, HashFunction, KeyEqual>::~ReadMostlyHashMap()
+    {
+        delete m_Table.load(std::memory_order_relaxed);
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    std::optional<Value> ReadMostlyHashMap<Key, Value, HashFunction, KeyEqual>::find(const Key& key) const
+    {
+        auto guard = m_Epochs.pin();
+        const Table* table = m_Table.load(std::memory_order_acquire);
+        if (auto it = table->find(key); it != table->end())
+            return (*it).second;
+        return std::nullopt;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    bool ReadMostlyHashMap<Key, Value, HashFunction, KeyEqual>::contains(const Key& key) const
+    {
+        auto guard = m_Epochs.pin();
+        return m_Table.load(std::memory_order_acquire)->contains(key);
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    template <typename F>
+    bool ReadMostlyHashMap<Key, Value, HashFunction, KeyEqual>::visit(const Key& key, F&& f) const
+    {
+        auto guard = m_Epochs.pin();
+        const Table* table = m_Table.load(std::memory_order_acquire);
+        auto it = table->find(key);
+        if (it == table->end())
+            return false;
+        std::invoke(std::forward<F>(f), (*it).second);
+        return true;
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    size_t ReadMostlyHashMap<Key, Value, HashFunction, KeyEqual>::size() const
+    {
+        auto guard = m_Epochs.pin();
+        return m_Table.load(std::memory_order_acquire)->size();
+    }
+
+    // Called with m_WriteLock held
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    void ReadMostlyHashMap<Key, Value, HashFunction, KeyEqual>::publish(Table* next)
+    {
+        Table* prev = m_Table.exchange(next, std::memory_order_acq_rel);
+        m_Epochs.retire(prev);
+        m_Epochs.reclaim();
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    template <typename F>
+    void ReadMostlyHashMap<Key, Value, HashFunction, KeyEqual>::update(F&& f)
+    {
+        std::lock_guard guard{m_WriteLock};
+        // Only writers replace the table and we hold the lock, so the current one cannot go away under us
+        Table* next = new Table(*m_Table.load(std::memory_order_relaxed));
+        try
+        {
+            std::invoke(std::forward<F>(f), *next);
+        }
+        catch (...)
+        {
+            delete next;
+            throw;
+        }
+        publish(next);
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    void ReadMostlyHashMap<Key, Value, HashFunction, KeyEqual>::insert(const Key& key, const Value& val)
+    {
+        update([&](Table& table) { table.insert(key, val); });
+    }
+
+    template <typename Key, typename Value, typename HashFunction, typename KeyEqual>
+    bool ReadMostlyHashMap<Key, Value, HashFunction, KeyEqual>::erase(const Key& key)
+    {
+        if (!contains(key))
+            return false;
+
+        bool erased = false;
+        update([&](Table& table) { erased = table.erase(key) != 0; });
+        return erased;
+    }
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include "Utilities/Hash.hpp"
+
+// Robin Hood hashing with backward-shift deletion.
+// See Emmanuel Goossaert's posts at https://codecapsule.com/2013/11/11/robin-hood-hashing/ and
+// https://codecapsule.com/2013/11/17/robin-hood-hashing-backward-shift-deletion/
+//
+// This is still linear probing, but every slot remembers how far it is from its ideal bucket (its probe distance).
+// On insertion, an element that is further away from home than the current occupant takes its place ("steals from
+// the rich"), and the displaced element continues probing. This keeps probe lengths short and uniform, and gives
+// two nice properties:
+//   - A lookup can stop as soon as it meets a slot whose distance is smaller than its own: had the key been there,
+//     it would have displaced that slot.
+//   - Deletion does not need tombstones: the following elements are shifted back by one until we reach an empty
+//     slot or an element that is already in its ideal bucket.
+namespace pysojic
+{
+    template <typename Key, typename Value, typename HashFunction = std::hash<Key>>
+    class RobinHoodHashMap
+    {
+        static_assert(std::is_default_constructible_v<Key>, "Key not default constructible!");
+        static_assert(std::is_default_constructible_v<Value>, "Value not default constructible!");
+
+        class Entry
+        {
+            friend class RobinHoodHashMap;
+        public:
+            Entry() = default;
+            Entry(const Key& key, const Value& val)
+                : key_{key}, value_{val}
+            {}
+
+        private:
+            Key key_{};
+            Value value_{};
+        };
+
+    public:
+        RobinHoodHashMap();
+
+        void insert(const Key& key, const Value& val);
+        void remove(const Key& key);
+        Value& operator[](const Key& key);
+        Value& at(const Key& key);
+        const Value& at(const Key& key) const;
+        bool contains(const Key& key) const;
+        void rehash(size_t new_size);
+
+        bool empty() const noexcept { return m_NumElems == 0; }
+        size_t size() const noexcept { return m_NumElems; }
+        size_t bucket_count() const noexcept { return m_Slots.size(); }
+        // No tombstones: every non-empty slot holds a live element
+        double load_factor() const noexcept { return static_cast<double>(m_NumElems) / m_Slots.size(); }
+
+    private:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+        static constexpr size_t m_InitialBucketCount = 16;
+        // m_Dist stores probe distance + 1 so that 0 can mean EMPTY
+        static constexpr std::uint8_t EMPTY = 0;
+        static constexpr std::uint8_t MAX_DIST = 255;
+
+        size_t hash_function(const Key& key) const;
+        size_t find_index(const Key& key) const;
+        size_t insert_new(Entry&& entry);
+
+    private:
+        std::vector<std::uint8_t> m_Dist;
+        std::vector<Entry> m_Slots;
+        size_t m_NumElems;
+        double m_MaxLoadFactor;
+    };
+
+    //------------ Implementation ------------
+
+    template <typename Key, typename Value, typename HashFunction>
+    size_t RobinHoodHashMap<Key, Value, HashFunction>::hash_function(const Key& key) const
+    {
+        return mixed_hash<HashFunction>(key) & (m_Slots.size() - 1);
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    RobinHoodHashMap<Key, Value, HashFunction>::RobinHoodHashMap()
+        : m_Dist(m_InitialBucketCount, EMPTY), m_Slots(m_InitialBucketCount), m_NumElems(0), m_MaxLoadFactor(0.875)
+    {
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    size_t RobinHoodHashMap<Key, Value, HashFunction>::find_index(const Key& key) const
+    {
+        const size_t mask = m_Slots.size() - 1;
+        size_t index = hash_function(key);
+
+        // Stop as soon as the slot is closer to its home than we are to ours (this includes EMPTY slots)
+        for (std::uint8_t dist = 1; m_Dist[index] >= dist; ++dist)
+        {
+            if (m_Dist[index] == dist && m_Slots[index].key_ == key)
+                return index;
+            index = (index + 1) & mask;
+        }
+        return npos;
+    }
+
+    // Insert an entry whose key is known to be absent and return the index where it ended up
+    template <typename Key, typename Value, typename HashFunction>
+    size_t RobinHoodHashMap<Key, Value, HashFunction>::insert_new(Entry&& entry)
+    {
+        if (m_NumElems + 1 > m_Slots.size() * m_MaxLoadFactor)
+            rehash(m_Slots.size() * 2);
+
+        const size_t mask = m_Slots.size() - 1;
+        size_t index = hash_function(entry.key_);
+        size_t result = npos;
+        std::uint8_t dist = 1;
+
+        while (true)
+        {
+            if (m_Dist[index] == EMPTY)
+            {
+                m_Dist[index] = dist;
+                m_Slots[index] = std::move(entry);
+                ++m_NumElems;
+                return result == npos ? index : result;
+            }
+            if (m_Dist[index] < dist)
+            {
+                // The occupant is richer than us: take its slot and carry it forward
+                std::swap(m_Dist[index], dist);
+                std::swap(m_Slots[index], entry);
+                if (result == npos)
+                    result = index;
+            }
+            index = (index + 1) & mask;
+
+            if (++dist == MAX_DIST)
+            {
+                // Pathological clustering: grow the table and place the entry we are still carrying.
+                // The element we were asked to insert may have moved, so look it up again afterwards.
+                Key key = result == npos ? entry.key_ : m_Slots[result].key_;
+                rehash(m_Slots.size() * 2);
+                insert_new(std::move(entry));
+                return find_index(key);
+            }
+        }
+    }
+
+    // Rehash: Create a new table of size new_size and reinsert all elements
+    template <typename Key, typename Value, typename HashFunction>
+    void RobinHoodHashMap<Key, Value, HashFunction>::rehash(size_t new_size)
+    {
+        new_size = std::bit_ceil(std::max(new_size, m_InitialBucketCount));
+        while (m_NumElems >= new_size * m_MaxLoadFactor)
+            new_size *= 2;
+
+        std::vector<std::uint8_t> old_dist(new_size, EMPTY);
+        std::vector<Entry> old_slots(new_size);
+        m_Dist.swap(old_dist);
+        m_Slots.swap(old_slots);
+        m_NumElems = 0;
+
+        for (size_t i = 0; i < old_slots.size(); ++i)
+        {
+            if (old_dist[i] != EMPTY)
+                insert_new(std::move(old_slots[i]));
+        }
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    void RobinHoodHashMap<Key, Value, HashFunction>::insert(const Key& key, const Value& val)
+    {
+        size_t index = find_index(key);
+        if (index != npos)
+        {
+            m_Slots[index].value_ = val;
+            return;
+        }
+        insert_new(Entry(key, val));
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    Value& RobinHoodHashMap<Key, Value, HashFunction>::operator[](const Key& key)
+    {
+        size_t index = find_index(key);
+        if (index == npos)
+            index = insert_new(Entry(key, Value{})); // Default-constructed value
+        return m_Slots[index].value_;
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    Value& RobinHoodHashMap<Key, Value, HashFunction>::at(const Key& key)
+    {
+        size_t index = find_index(key);
+        if (index == npos)
+            throw std::out_of_range{"Key not found"};
+        return m_Slots[index].value_;
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    const Value& RobinHoodHashMap<Key, Value, HashFunction>::at(const Key& key) const
+    {
+        size_t index = find_index(key);
+        if (index == npos)
+            throw std::out_of_range{"Key not found"};
+        return m_Slots[index].value_;
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    bool RobinHoodHashMap<Key, Value, HashFunction>::contains(const Key& key) const
+    {
+        return find_index(key) != npos;
+    }
+
+    // Backward-shift deletion: pull every following element that is not in its ideal bucket one slot back
+    template <typename Key, typename Value, typename HashFunction>
+    void RobinHoodHashMap<Key, Value, HashFunction>::remove(const Key& key)
+    {
+        size_t index = find_index(key);
+        if (index == npos)
+            throw std::out_of_range("Key not found");
+
+        const size_t mask = m_Slots.size() - 1;
+        size_t next = (index + 1) & mask;
+        while (m_Dist[next] > 1)
+        {
+            m_Dist[index] = m_Dist[next] - 1;
+            m_Slots[index] = std::move(m_Slots[next]);
+            index = next;
+            next = (next + 1) & mask;
+        }
+
+        m_Dist[index] = EMPTY;
+        m_Slots[index] = Entry{}; // release whatever the key/value owned
+        --m_NumElems;
+    }
+}
@@ -1,95 +1,365 @@
 #pragma once
 
 #include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
 #include <memory>
-#include <array>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
 
 // Fixed Lock-free Single Producer, Single Consumer Queue
 // Heavily inspired by rigtorp impl here: https://github.com/rigtorp/SPSCQueue
+//
+// Each index is written by one side and read by the other, so every time the other side reads it the cache line
+// has to travel between the two cores. To keep that rare, each side keeps a private copy of the other side's index
+// next to its own index, and only reloads the real one when the copy says the queue is full (producer) or
+// empty (consumer). The copy can only lag behind, which errs on the safe side: the producer may see less free
+// space than there is, the consumer fewer elements, never the opposite.
+// In a steady stream the shared index is reloaded about once per lap of the ring instead of once per element.
+//
+// The slots are raw storage: an element is constructed in its slot by push/emplace and destroyed when it is
+// popped, so T needs no default constructor and can be move-only (e.g. pysojic::UniquePtr). For big payloads,
+// emplace() builds the element directly in the slot and front() + pop() let the consumer work on it in place:
+//
+//   queue.emplace(args...);                // producer
+//   if (Message* msg = queue.front())      // consumer
+//   {
+//       handle(*msg);
+//       queue.pop();                       // destroys the element and hands the slot back to the producer
+//   }
+//
+// With Capacity = std::dynamic_extent the capacity is given to the constructor instead (rounded up to a power of
+// two) and the ring is allocated with Allocator, e.g. pysojic::HugePageAllocator for big rings that would
+// otherwise pay a TLB miss every few KB:
+//
+//   SPSCQueue<Message, std::dynamic_extent, pysojic::HugePageAllocator<Message>> queue(config.queue_size);
+//
+// The protocol is the same for both, only where the slots live differs (see spsc_detail::RingStorage).
 
-template<typename T, std::size_t Capacity>
+namespace spsc_detail
+{
+    inline constexpr std::size_t CACHE_LINE = 64;
+
+    // Compile-time capacity: the slots are embedded in the queue, on their own cache lines so that writing an
+    // element never invalidates the line holding an index (and the other way around)
+    template <typename T, std::size_t Capacity, typename Allocator>
+    class RingStorage
+    {
+    public:
+        static constexpr std::size_t capacity() noexcept { return Capacity; }
+        void* slot(std::size_t i) noexcept { return m_Data + i * sizeof(T); }
+
+    private:
+        alignas(CACHE_LINE) alignas(T) std::byte m_Data[Capacity * sizeof(T)];
+    };
+
+    // Runtime capacity: the slots are allocated with Allocator. The queue only keeps the pointer and the capacity,
+    // which both sides read but nobody writes after construction.
+    template <typename T, typename Allocator>
+    class RingStorage<T, std::dynamic_extent, Allocator>
+    {
+        using alloc = std::allocator_traits<Allocator>;
+        static_assert(std::is_same_v<typename alloc::value_type, T>, "Allocator must allocate T");
+
+        // Unused slots on both sides of the ring, so that it shares no cache line with whatever the allocator
+        // put next to it
+        static constexpr std::size_t PADDING = (CACHE_LINE - 1) / sizeof(T) + 1;
+
+    public:
+        RingStorage(std::size_t capacity, const Allocator& allocator)
+            : m_Allocator{allocator}
+        {
+            if (capacity > alloc::max_size(m_Allocator) / 2 - 2 * PADDING)
+                throw std::length_error("SPSCQueue: capacity too large");
+            m_Capacity = std::bit_ceil(std::max<std::size_t>(capacity, 2));
+            m_Buffer = alloc::allocate(m_Allocator, m_Capacity + 2 * PADDING);
+        }
+
+        ~RingStorage()
+        {
+            alloc::deallocate(m_Allocator, m_Buffer, m_Capacity + 2 * PADDING);
+        }
+
+        RingStorage(const RingStorage&) = delete;
+        RingStorage& operator=(const RingStorage&) = delete;
+
+        std::size_t capacity() const noexcept { return m_Capacity; }
+        void* slot(std::size_t i) noexcept { return m_Buffer + PADDING + i; }
+
+    private:
+        [[no_unique_address]] Allocator m_Allocator;
+        T* m_Buffer;
+        std::size_t m_Capacity;
+    };
+}
+
+template<typename T, std::size_t Capacity, typename Allocator = std::allocator<T>>
 class SPSCQueue {
 public:
     // compile‐time proof that Capacity is a power of two ≥ 2
-    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+    static_assert(Capacity == std::dynamic_extent || (Capacity >= 2 && (Capacity & (Capacity - 1)) == 0),
                   "Capacity must be ≥2 and a power of two");
 
-    SPSCQueue() = default;
+    SPSCQueue() requires (Capacity != std::dynamic_extent) = default;
+    /// Runtime capacity, rounded up to a power of two (see capacity())
+    explicit SPSCQueue(std::size_t capacity, const Allocator& allocator = Allocator())
+        requires (Capacity == std::dynamic_extent)
+        : m_Ring{capacity, allocator}
+    {
+    }
     // no copies or moves
     SPSCQueue(const SPSCQueue&) = delete;
     SPSCQueue& operator=(const SPSCQueue&) = delete;
     SPSCQueue(SPSCQueue&&) = delete;
     SPSCQueue& operator=(SPSCQueue&&) = delete;
 
-    bool push(const T& value) noexcept 
+    ~SPSCQueue()
     {
+        auto r = m_ReadIdx.load(std::memory_order_relaxed);
         auto w = m_WriteIdx.load(std::memory_order_relaxed);
-        auto r = m_ReadIdx .load(std::memory_order_acquire);
+        for (; r != w; ++r)
+            std::destroy_at(element(r));
+    }
 
-        // full when write - read == Capacity
-        if (w - r == Capacity) 
-            return false;
+    /// Construct an element in place from args, returns false (and constructs nothing) if the queue is full.
+    /// If the constructor throws, nothing is pushed.
+    template <typename... Args>
+    bool emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>)
+    {
+        auto w = m_WriteIdx.load(std::memory_order_relaxed);
 
-        m_Data[w & mask()] = value;
+        // full when write - read == capacity
+        if (w - m_ReadIdxCache == capacity())
+        {
+            m_ReadIdxCache = m_ReadIdx.load(std::memory_order_acquire);
+            if (w - m_ReadIdxCache == capacity())
+                return false;
+        }
+
+        ::new (storage(w)) T(std::forward<Args>(args)...);
         m_WriteIdx.store(w + 1, std::memory_order_release);
         return true;
     }
 
-    bool pop(T& out) noexcept 
+    bool push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>)
     {
-        auto r = m_ReadIdx .load(std::memory_order_relaxed);
-        auto w = m_WriteIdx.load(std::memory_order_acquire);
+        return emplace(value);
+    }
+
+    bool push(T&& value) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        return emplace(std::move(value));
+    }
+
+    /// Move the front element into out and remove it, returns false if the queue is empty
+    bool pop(T& out) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        auto r = m_ReadIdx.load(std::memory_order_relaxed);
 
         // empty when write == read
-        if (r == w)
-            return false;
+        if (r == m_WriteIdxCache)
+        {
+            m_WriteIdxCache = m_WriteIdx.load(std::memory_order_acquire);
+            if (r == m_WriteIdxCache)
+                return false;
+        }
 
-        out = m_Data[r & mask()];
+        T* elem = element(r);
+        out = std::move(*elem);
+        std::destroy_at(elem);
         m_ReadIdx.store(r + 1, std::memory_order_release);
         return true;
     }
 
-    /// Peek at the next element (precondition: !empty())
-    T& front() noexcept 
+    /// Pointer to the front element, or nullptr if the queue is empty. The element stays in the queue (and
+    /// the pointer valid) until pop().
+    T* front() noexcept
     {
-        auto r = m_ReadIdx.load(std::memory_order_acquire);
+        auto r = m_ReadIdx.load(std::memory_order_relaxed);
+        if (r == m_WriteIdxCache)
+        {
+            m_WriteIdxCache = m_WriteIdx.load(std::memory_order_acquire);
+            if (r == m_WriteIdxCache)
+                return nullptr;
+        }
+        return element(r);
+    }
+
+    /// Destroy the front element and release its slot (precondition: front() != nullptr)
+    void pop() noexcept
+    {
+        auto r = m_ReadIdx.load(std::memory_order_relaxed);
         assert(r != m_WriteIdx.load(std::memory_order_acquire)
-            && "front() on empty queue");
-        return m_Data[r & mask()];
+            && "pop() on empty queue");
+        std::destroy_at(element(r));
+        m_ReadIdx.store(r + 1, std::memory_order_release);
     }
 
-    std::size_t size() const noexcept 
+    // Bulk versions: a whole run of elements is copied with a single load of the other side's index and a single
+    // publish of ours, instead of one of each per element (each of which can be a cache miss on the other core).
+
+    /// Push as many elements of values as fit, returns how many were pushed.
+    /// If a copy throws, nothing is pushed.
+    std::size_t push_n(std::span<const T> values) noexcept(std::is_nothrow_copy_constructible_v<T>)
+    {
+        auto w = m_WriteIdx.load(std::memory_order_relaxed);
+
+        if (capacity() - (w - m_ReadIdxCache) < values.size())
+            m_ReadIdxCache = m_ReadIdx.load(std::memory_order_acquire);
+        std::size_t n = std::min(values.size(), capacity() - (w - m_ReadIdxCache));
+        // the free space may wrap around the end of the buffer
+        std::size_t first = std::min(n, capacity() - (w & mask()));
+        std::uninitialized_copy_n(values.begin(), first, static_cast<T*>(storage(w)));
+        if constexpr (std::is_nothrow_copy_constructible_v<T>)
+        {
+            std::uninitialized_copy_n(values.begin() + first, n - first, static_cast<T*>(storage(0)));
+        }
+        else
+        {
+            try
+            {
+                std::uninitialized_copy_n(values.begin() + first, n - first, static_cast<T*>(storage(0)));
+            }
+            catch (...)
+            {
+                std::destroy_n(element(w), first);
+                throw;
+            }
+        }
+
+        if (n != 0)
+            m_WriteIdx.store(w + n, std::memory_order_release);
+        return n;
+    }
+
+    /// Pop up to out.size() elements into out, returns how many were popped.
+    /// If a move throws, the elements before it are popped and that one stays at the front.
+    std::size_t pop_n(std::span<T> out) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        auto r = m_ReadIdx.load(std::memory_order_relaxed);
+
+        if (m_WriteIdxCache - r < out.size())
+            m_WriteIdxCache = m_WriteIdx.load(std::memory_order_acquire);
+        std::size_t n = std::min(out.size(), m_WriteIdxCache - r);
+        if (n == 0)
+            return 0;
+
+        if constexpr (std::is_nothrow_move_assignable_v<T>)
+        {
+            // Moved as (at most) two contiguous ranges, which is a memcpy for trivially copyable types
+            std::size_t first = std::min(n, capacity() - (r & mask()));
+            T* src = element(r);
+            std::move(src, src + first, out.begin());
+            std::destroy_n(src, first);
+            std::move(element(0), element(0) + (n - first), out.begin() + first);
+            std::destroy_n(element(0), n - first);
+
+            m_ReadIdx.store(r + n, std::memory_order_release);
+            return n;
+        }
+        else
+        {
+            auto move_out = [dst = out.begin()](T& elem) mutable { *dst++ = std::move(elem); };
+            return consume(r, r + n, move_out);
+        }
+    }
+
+    /// Call f(T&) on every element currently in the queue, then release them all at once.
+    /// Returns the number of elements consumed. If f throws, the elements before the one it threw on are
+    /// consumed and that one stays at the front.
+    template <typename F>
+    std::size_t try_consume_all(F&& f)
+    {
+        // Everything currently published is wanted, so the write index is always reloaded here
+        auto r = m_ReadIdx.load(std::memory_order_relaxed);
+        auto w = m_WriteIdxCache = m_WriteIdx.load(std::memory_order_acquire);
+        if (r == w)
+            return 0;
+
+        return consume(r, w, f);
+    }
+
+    std::size_t size() const noexcept
     {
         auto w = m_WriteIdx.load(std::memory_order_acquire);
         auto r = m_ReadIdx .load(std::memory_order_acquire);
         return w - r;
     }
 
-    constexpr std::size_t capacity() const noexcept 
+    constexpr std::size_t capacity() const noexcept
     {
-        return Capacity;
+        return m_Ring.capacity();
     }
 
-    bool empty() const noexcept 
+    bool empty() const noexcept
     {
         return m_ReadIdx.load(std::memory_order_acquire)
              == m_WriteIdx.load(std::memory_order_acquire);
     }
 
-    bool full() const noexcept 
+    bool full() const noexcept
     {
         return (m_WriteIdx.load(std::memory_order_acquire)
               - m_ReadIdx.load(std::memory_order_acquire))
-             == Capacity;
+             == capacity();
     }
 
 private:
-    std::size_t mask() const noexcept 
+    std::size_t mask() const noexcept
+    {
+        return capacity() - 1;
+    }
+
+    // Raw slot of index i, to construct an element into
+    void* storage(std::size_t i) noexcept
+    {
+        return m_Ring.slot(i & mask());
+    }
+
+    // The element living in the slot of index i
+    T* element(std::size_t i) noexcept
     {
-        return Capacity - 1;
+        return std::launder(static_cast<T*>(storage(i)));
     }
 
-    std::array<T, Capacity> m_Data;
-    alignas(std::hardware_constructive_interference_size) std::atomic<std::size_t> m_ReadIdx  {0};
-    alignas(std::hardware_constructive_interference_size) std::atomic<std::size_t> m_WriteIdx {0};
-};
\ No newline at end of file
+    // Hand the elements [r, w) to f one by one, destroying each after it, then release them with one store
+    template <typename F>
+    std::size_t consume(std::size_t r, std::size_t w, F& f)
+    {
+        auto i = r;
+        try
+        {
+            for (; i != w; ++i)
+            {
+                T* elem = element(i);
+                f(*elem);
+                std::destroy_at(elem);
+            }
+        }
+        catch (...)
+        {
+            m_ReadIdx.store(i, std::memory_order_release);
+            throw;
+        }
+        m_ReadIdx.store(w, std::memory_order_release);
+        return w - r;
+    }
+
+    static constexpr std::size_t CACHE_LINE = spsc_detail::CACHE_LINE;
+
+    spsc_detail::RingStorage<T, Capacity, Allocator> m_Ring;
+
+    // Each side's index sits on its own cache line with the cached copy it uses
+    // Consumer side
+    alignas(CACHE_LINE) std::atomic<std::size_t> m_ReadIdx {0};
+    std::size_t m_WriteIdxCache {0};
+
+    // Producer side
+    alignas(CACHE_LINE) std::atomic<std::size_t> m_WriteIdx {0};
+    std::size_t m_ReadIdxCache {0};
+};
@@ -4,6 +4,8 @@
 #include <algorithm>
 #include <iostream>
 
+#include "Utilities/Relocation.hpp"
+
 class String 
 {
 public:
@@ -50,9 +52,17 @@ private:
     };
 };
 
+namespace pysojic
+{
+    // Unlike most std::string implementations, data() is recomputed from the flag instead of being a pointer into
+    // the object's own SSO buffer, so a String can be relocated by copying its bytes (see Utilities/Relocation.hpp)
+    template <>
+    struct is_trivially_relocatable<String> : std::true_type {};
+}
+
 //--------- Implementation ---------
 
-String::String()
+String::String() noexcept
 {
     init_sso();
 }
@@ -0,0 +1,341 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include "Utilities/Hash.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// SwissTable-style open addressing, see Abseil's flat_hash_map and Matt Kulukundis' CppCon 2017 talk
+// "Designing a Fast, Efficient, Cache-friendly Hash Table, Step by Step".
+//
+// Next to the slot array we keep one control byte per slot:
+//   EMPTY   = 0b10000000
+//   DELETED = 0b11111110
+//   FULL    = 0b0hhhhhhh, where hhhhhhh are 7 bits of the hash (H2)
+// The remaining bits of the hash (H1) pick the group where probing starts. A whole group of control bytes
+// (16 with SSE2, 32 with AVX2) is compared against H2 with a single SIMD compare, so the keys themselves
+// are only touched on tag matches (a false positive happens with probability ~1/128 per full slot).
+namespace pysojic
+{
+    namespace swiss_detail
+    {
+        using ctrl_t = std::int8_t;
+
+        inline constexpr ctrl_t EMPTY = -128;
+        inline constexpr ctrl_t DELETED = -2;
+
+#if defined(__AVX2__)
+        inline constexpr std::size_t GROUP_WIDTH = 32;
+#else
+        inline constexpr std::size_t GROUP_WIDTH = 16;
+#endif
+
+        // A bitmask with bit i set when the i-th control byte of the group matched
+        using BitMask = std::uint32_t;
+
+        class Group
+        {
+        public:
+            explicit Group(const ctrl_t* pos) noexcept
+            {
+#if defined(__AVX2__)
+                m_Ctrl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+#elif defined(__SSE2__)
+                m_Ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+#else
+                m_Ctrl = pos;
+#endif
+            }
+
+            BitMask match(ctrl_t h2) const noexcept
+            {
+#if defined(__AVX2__)
+                return static_cast<BitMask>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(m_Ctrl, _mm256_set1_epi8(h2))));
+#elif defined(__SSE2__)
+                return static_cast<BitMask>(_mm_movemask_epi8(_mm_cmpeq_epi8(m_Ctrl, _mm_set1_epi8(h2))));
+#else
+                BitMask mask = 0;
+                for (std::size_t i = 0; i < GROUP_WIDTH; ++i)
+                    mask |= static_cast<BitMask>(m_Ctrl[i] == h2) << i;
+                return mask;
+#endif
+            }
+
+            BitMask match_empty() const noexcept
+            {
+                return match(EMPTY);
+            }
+
+            // EMPTY and DELETED are the only control bytes with the sign bit set, so movemask gives them directly
+            BitMask match_empty_or_deleted() const noexcept
+            {
+#if defined(__AVX2__)
+                return static_cast<BitMask>(_mm256_movemask_epi8(m_Ctrl));
+#elif defined(__SSE2__)
+                return static_cast<BitMask>(_mm_movemask_epi8(m_Ctrl));
+#else
+                BitMask mask = 0;
+                for (std::size_t i = 0; i < GROUP_WIDTH; ++i)
+                    mask |= static_cast<BitMask>(m_Ctrl[i] < 0) << i;
+                return mask;
+#endif
+            }
+
+        private:
+#if defined(__AVX2__)
+            __m256i m_Ctrl;
+#elif defined(__SSE2__)
+            __m128i m_Ctrl;
+#else
+            const ctrl_t* m_Ctrl;
+#endif
+        };
+    }
+
+    template <typename Key, typename Value, typename HashFunction = std::hash<Key>>
+    class SwissHashMap
+    {
+        static_assert(std::is_default_constructible_v<Key>, "Key not default constructible!");
+        static_assert(std::is_default_constructible_v<Value>, "Value not default constructible!");
+
+        using ctrl_t = swiss_detail::ctrl_t;
+        using Group = swiss_detail::Group;
+
+        class Entry
+        {
+            friend class SwissHashMap;
+        public:
+            Entry() = default;
+            Entry(const Key& key, const Value& val)
+                : key_{key}, value_{val}
+            {}
+
+        private:
+            Key key_{};
+            Value value_{};
+        };
+
+    public:
+        SwissHashMap();
+
+        void insert(const Key& key, const Value& val);
+        void remove(const Key& key);
+        Value& operator[](const Key& key);
+        Value& at(const Key& key);
+        const Value& at(const Key& key) const;
+        bool contains(const Key& key) const;
+        void rehash(size_t new_size);
+
+        bool empty() const noexcept { return m_NumElems == 0; }
+        size_t size() const noexcept { return m_NumElems; }
+        size_t bucket_count() const noexcept { return m_Slots.size(); }
+        double load_factor() const noexcept { return static_cast<double>(m_NumElems) / m_Slots.size(); }
+
+    private:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+        static constexpr size_t m_InitialBucketCount = swiss_detail::GROUP_WIDTH;
+
+        static size_t hash_function(const Key& key) noexcept;
+        static size_t H1(size_t hash) noexcept { return hash >> 7; }
+        static ctrl_t H2(size_t hash) noexcept { return static_cast<ctrl_t>(hash & 0x7F); }
+
+        size_t find_index(const Key& key, size_t hash) const;
+        size_t find_insert_slot(size_t hash) const noexcept;
+        void reserve_one();
+
+    private:
+        std::vector<ctrl_t> m_Ctrl;
+        std::vector<Entry> m_Slots;
+        size_t m_NumElems;
+        size_t m_NumDeleted;
+        double m_MaxLoadFactor;
+    };
+
+    //------------ Implementation ------------
+
+    // H2 is taken from the low bits and H1 from the rest, so the hash has to be well mixed whatever the hasher.
+    // std::hash<int> is the identity: without this finalizer, sequential keys would all share the same H1
+    // (i.e. the same starting group). See Utilities/Hash.hpp.
+    template <typename Key, typename Value, typename HashFunction>
+    size_t SwissHashMap<Key, Value, HashFunction>::hash_function(const Key& key) noexcept
+    {
+        return static_cast<size_t>(fmix64(HashFunction{}(key)));
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    SwissHashMap<Key, Value, HashFunction>::SwissHashMap()
+        : m_Ctrl(m_InitialBucketCount, swiss_detail::EMPTY), m_Slots(m_InitialBucketCount),
+        m_NumElems(0), m_NumDeleted(0), m_MaxLoadFactor(0.875)
+    {
+    }
+
+    // Probe group by group (groups are aligned on GROUP_WIDTH) using triangular steps,
+    // which visits every group exactly once since the number of groups is a power of two.
+    // A group containing an EMPTY byte ends the probe: the key would have been placed there.
+    template <typename Key, typename Value, typename HashFunction>
+    size_t SwissHashMap<Key, Value, HashFunction>::find_index(const Key& key, size_t hash) const
+    {
+        const size_t mask = m_Ctrl.size() - 1;
+        const ctrl_t h2 = H2(hash);
+        size_t pos = H1(hash) & mask & ~(swiss_detail::GROUP_WIDTH - 1);
+
+        for (size_t step = swiss_detail::GROUP_WIDTH; ; pos = (pos + step) & mask, step += swiss_detail::GROUP_WIDTH)
+        {
+            Group group{&m_Ctrl[pos]};
+            for (auto bits = group.match(h2); bits; bits &= bits - 1)
+            {
+                size_t index = pos + std::countr_zero(bits);
+                if (m_Slots[index].key_ == key)
+                    return index;
+            }
+            if (group.match_empty())
+                return npos;
+        }
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    size_t SwissHashMap<Key, Value, HashFunction>::find_insert_slot(size_t hash) const noexcept
+    {
+        const size_t mask = m_Ctrl.size() - 1;
+        size_t pos = H1(hash) & mask & ~(swiss_detail::GROUP_WIDTH - 1);
+
+        for (size_t step = swiss_detail::GROUP_WIDTH; ; pos = (pos + step) & mask, step += swiss_detail::GROUP_WIDTH)
+        {
+            if (auto bits = Group{&m_Ctrl[pos]}.match_empty_or_deleted())
+                return pos + std::countr_zero(bits);
+        }
+    }
+
+    // Tombstones count against the load factor: probes have to walk past them just like full slots.
+    // If most of the budget is taken by tombstones, rehashing in place is enough to clean them up.
+    template <typename Key, typename Value, typename HashFunction>
+    void SwissHashMap<Key, Value, HashFunction>::reserve_one()
+    {
+        if (m_NumElems + m_NumDeleted + 1 > m_Slots.size() * m_MaxLoadFactor)
+        {
+            if (m_NumDeleted > m_NumElems)
+                rehash(m_Slots.size());
+            else
+                rehash(m_Slots.size() * 2);
+        }
+    }
+
+    // Rehash: Create a new table of size new_size (rounded up to a power of two) and reinsert all FULL slots
+    template <typename Key, typename Value, typename HashFunction>
+    void SwissHashMap<Key, Value, HashFunction>::rehash(size_t new_size)
+    {
+        new_size = std::bit_ceil(std::max(new_size, m_InitialBucketCount));
+        while (m_NumElems >= new_size * m_MaxLoadFactor)
+            new_size *= 2;
+
+        std::vector<ctrl_t> old_ctrl(new_size, swiss_detail::EMPTY);
+        std::vector<Entry> old_slots(new_size);
+        m_Ctrl.swap(old_ctrl);
+        m_Slots.swap(old_slots);
+        m_NumDeleted = 0;
+
+        for (size_t i = 0; i < old_ctrl.size(); ++i)
+        {
+            if (old_ctrl[i] >= 0)
+            {
+                size_t hash = hash_function(old_slots[i].key_);
+                size_t index = find_insert_slot(hash);
+                m_Ctrl[index] = H2(hash);
+                m_Slots[index] = std::move(old_slots[i]);
+            }
+        }
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    void SwissHashMap<Key, Value, HashFunction>::insert(const Key& key, const Value& val)
+    {
+        size_t hash = hash_function(key);
+        size_t index = find_index(key, hash);
+        if (index != npos)
+        {
+            m_Slots[index].value_ = val;
+            return;
+        }
+
+        reserve_one();
+        index = find_insert_slot(hash);
+        // The entry first: if copying the key or value throws, the slot is still free and the counts untouched
+        m_Slots[index] = Entry(key, val);
+        if (m_Ctrl[index] == swiss_detail::DELETED)
+            --m_NumDeleted;
+        m_Ctrl[index] = H2(hash);
+        ++m_NumElems;
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    Value& SwissHashMap<Key, Value, HashFunction>::operator[](const Key& key)
+    {
+        size_t hash = hash_function(key);
+        size_t index = find_index(key, hash);
+        if (index != npos)
+            return m_Slots[index].value_;
+
+        reserve_one();
+        index = find_insert_slot(hash);
+        m_Slots[index] = Entry(key, Value{}); // Default-constructed value, before marking the slot (see insert)
+        if (m_Ctrl[index] == swiss_detail::DELETED)
+            --m_NumDeleted;
+        m_Ctrl[index] = H2(hash);
+        ++m_NumElems;
+        return m_Slots[index].value_;
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    Value& SwissHashMap<Key, Value, HashFunction>::at(const Key& key)
+    {
+        size_t index = find_index(key, hash_function(key));
+        if (index == npos)
+            throw std::out_of_range{"Key not found"};
+        return m_Slots[index].value_;
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    const Value& SwissHashMap<Key, Value, HashFunction>::at(const Key& key) const
+    {
+        size_t index = find_index(key, hash_function(key));
+        if (index == npos)
+            throw std::out_of_range{"Key not found"};
+        return m_Slots[index].value_;
+    }
+
+    template <typename Key, typename Value, typename HashFunction>
+    bool SwissHashMap<Key, Value, HashFunction>::contains(const Key& key) const
+    {
+        return find_index(key, hash_function(key)) != npos;
+    }
+
+    // If the group of the erased slot still has an EMPTY byte, no probe sequence can have gone past it
+    // (it would have stopped on that EMPTY), so the slot can be marked EMPTY instead of leaving a tombstone.
+    template <typename Key, typename Value, typename HashFunction>
+    void SwissHashMap<Key, Value, HashFunction>::remove(const Key& key)
+    {
+        size_t index = find_index(key, hash_function(key));
+        if (index == npos)
+            throw std::out_of_range("Key not found");
+
+        if (Group{&m_Ctrl[index & ~(swiss_detail::GROUP_WIDTH - 1)]}.match_empty())
+        {
+            m_Ctrl[index] = swiss_detail::EMPTY;
+        }
+        else
+        {
+            m_Ctrl[index] = swiss_detail::DELETED;
+            ++m_NumDeleted;
+        }
+        m_Slots[index] = Entry{}; // release whatever the key/value owned
+        --m_NumElems;
+    }
+}
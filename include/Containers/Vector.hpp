@@ -2,8 +2,84 @@
 
 #include <utility>
 #include <memory>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <ranges>
+#include <stdexcept>
+
+#include "Utilities/DefaultInitAllocator.hpp"
+#include "Utilities/Relocation.hpp"
+
+// How much a Vector grows when it runs out of space: next_capacity(capacity, required, elemSize) returns the new
+// capacity, at least required (the number of elements the vector must be able to hold).
+//   - Double: the classic x2. Fewest reallocations, but a freed block can never be reused by a later one: the sum
+//     of all the previous blocks is always smaller than the next.
+//   - OneAndHalf: x1.5 (MSVC, folly::fbvector). A few more reallocations, less memory left unused, and after a few
+//     steps the freed blocks add up to enough for the allocator to recycle them.
+//   - SizeClass: x1.5, then rounded up to the block size malloc would really hand out. jemalloc / tcmalloc serve
+//     requests from size classes (16-byte steps up to 128 bytes, then 4 classes per power of two), whatever is
+//     rounded up is lost anyway: the capacity might as well use it.
+namespace pysojic::vector_growth
+{
+    struct Double
+    {
+        static constexpr size_t next_capacity(size_t capacity, size_t required, size_t) noexcept
+        {
+            return std::max(required, capacity * 2);
+        }
+    };
+
+    struct OneAndHalf
+    {
+        static constexpr size_t next_capacity(size_t capacity, size_t required, size_t) noexcept
+        {
+            return std::max(required, capacity + capacity / 2);
+        }
+    };
+
+    struct SizeClass
+    {
+        static constexpr size_t next_capacity(size_t capacity, size_t required, size_t elemSize) noexcept
+        {
+            size_t bytes = std::max(required, capacity + capacity / 2) * elemSize;
+            size_t step = bytes <= 128 ? 16 : std::bit_floor(bytes - 1) / 4;
+            return std::max(required, ((bytes + step - 1) & ~(step - 1)) / elemSize);
+        }
+    };
+}
 
-template<typename T, typename Allocator = std::allocator<T>>
+namespace pysojic::vector_detail
+{
+    // Room for N elements inside the Vector object itself, nothing at all for N == 0
+    template <typename T, size_t N>
+    struct InlineStorage
+    {
+        alignas(T) std::byte m_Data[N * sizeof(T)];
+
+        T* data() noexcept { return reinterpret_cast<T*>(m_Data); }
+    };
+
+    template <typename T>
+    struct InlineStorage<T, 0>
+    {
+        T* data() noexcept { return nullptr; }
+    };
+}
+
+// InlineCapacity > 0 makes it a small vector (see SmallVector below): the first InlineCapacity elements live in a
+// buffer inside the object, the heap is only used past that.
+// Elements whose move constructor may throw are copied rather than moved to a new buffer (as std::vector does), so
+// that a throw while growing leaves the Vector as it was; move-only ones are moved and only the basic guarantee
+// holds. Moving a small vector moves its inline elements: noexcept only when that cannot throw.
+template<typename T, typename Allocator = std::allocator<T>, typename GrowthPolicy = pysojic::vector_growth::Double,
+         size_t InlineCapacity = 0>
 class Vector
 {
 public:
@@ -11,12 +87,14 @@ public:
 
     Vector();
     Vector(size_t size) ;
+    // size default-initialized elements: left uninitialized if T is trivial (see Utilities/DefaultInitAllocator.hpp)
+    Vector(size_t size, pysojic::default_init_t);
     Vector(size_t size, const T& value);
     Vector(std::initializer_list<T> init);
-    Vector(const Vector<T, Allocator>& other);
-    Vector& operator= (const Vector<T, Allocator>& other);
-    Vector(Vector<T, Allocator>&& other) noexcept;
-    Vector<T, Allocator>& operator=(Vector<T, Allocator>&& other) noexcept;
+    Vector(const Vector<T, Allocator, GrowthPolicy, InlineCapacity>& other);
+    Vector& operator= (const Vector<T, Allocator, GrowthPolicy, InlineCapacity>& other);
+    Vector(Vector<T, Allocator, GrowthPolicy, InlineCapacity>&& other) noexcept(NOTHROW_TAKE);
+    Vector<T, Allocator, GrowthPolicy, InlineCapacity>& operator=(Vector<T, Allocator, GrowthPolicy, InlineCapacity>&& other) noexcept(NOTHROW_TAKE);
     ~Vector() noexcept;    
 
     void clear() noexcept;
@@ -27,112 +105,201 @@ public:
     void emplace_back(Args&&... args);
     void shrink_to_fit();
     void resize(size_t newSize);
+    // Elements added by growing are default-initialized instead of value-initialized: no zero-fill for trivial T,
+    // for buffers that are about to be overwritten anyway (read(), recv(), memcpy...)
+    void resize(size_t newSize, pysojic::default_init_t);
+    // Same, restricted to types whose new elements really are left uninitialized
+    void resize_uninitialized(size_t newSize) requires std::is_trivially_default_constructible_v<T>
+    {
+        resize(newSize, pysojic::default_init);
+    }
     void reserve(size_t newCapacity);
 
+    // Bulk insertion: with forward iterators (or a sized range) the final size is known up front, so there is at
+    // most one reallocation however many elements come in. The source must not be elements of this Vector.
+    template <std::input_iterator InputIt>
+    void append(InputIt first, InputIt last);
+    // Insert the elements of range before index pos (pos == size() appends)
+    template <std::ranges::input_range R>
+    void insert_range(size_t pos, R&& range);
+
     T& front() noexcept { return m_Arr[0]; }
     const T& front() const noexcept{ return m_Arr[0]; }
     T& back() noexcept { return m_Arr[m_Size - 1]; }
     const T& back() const noexcept{ return m_Arr[m_Size - 1]; }
     const T& operator[](size_t index) const noexcept { return m_Arr[index]; }
     T& operator[](size_t index) noexcept { return m_Arr[index]; }
+    T* data() noexcept { return m_Arr; }
+    const T* data() const noexcept { return m_Arr; }
     size_t capacity() const noexcept { return m_Capacity; }
     size_t size() const noexcept { return m_Size; }
     void print() const;
 
 private:
+    // Trivially relocatable elements in std::allocator memory: the buffer comes from malloc instead (std::allocator
+    // is stateless and only hands out raw memory, nobody can tell the difference) so that growing is a realloc.
+    // realloc extends the block in place when the memory after it is free, and big blocks (mmap-ed by malloc) are
+    // grown by remapping their pages (mremap on Linux), without copying a single element.
+    // malloc only guarantees alignof(std::max_align_t), over-aligned types go through the allocator.
+    // The DefaultInitAllocator adaptor over std::allocator only changes how elements are constructed, same thing.
+    static constexpr bool STD_ALLOCATOR = std::is_same_v<Allocator, std::allocator<T>>
+                                       || std::is_same_v<Allocator, pysojic::DefaultInitAllocator<T>>;
+    static constexpr bool USE_REALLOC = pysojic::is_trivially_relocatable_v<T>
+                                     && STD_ALLOCATOR
+                                     && alignof(T) <= alignof(std::max_align_t);
+    // Constructing without arguments default-initializes with this allocator: skip it altogether and default-
+    // initialize in bulk (a no-op for trivial T, instead of a loop of empty construct calls)
+    static constexpr bool DEFAULT_INIT = pysojic::is_default_init_allocator_v<Allocator>;
+    static constexpr bool NOTHROW_RELOCATE = std::is_nothrow_move_constructible_v<T> || pysojic::is_trivially_relocatable_v<T>;
+    // Only a small vector relocates elements when it is moved, any other just steals the buffer
+    static constexpr bool NOTHROW_TAKE = NOTHROW_RELOCATE || InlineCapacity == 0;
+
+    T* allocate(size_t n);
+    void deallocate(T* ptr, size_t n) noexcept;
     void reallocate(size_t newCapacity);
-    
+    // Move the m_Size elements at src to the raw memory at dest and destroy the originals. If a copy throws,
+    // nothing was destroyed and dest is raw memory again.
+    void relocate(T* src, T* dest) noexcept(NOTHROW_RELOCATE);
+    // Take other's elements, this has none and holds no heap buffer. Steals other's heap buffer, or moves the
+    // elements one by one out of its inline buffer.
+    void take(Vector& other) noexcept(NOTHROW_TAKE);
+    bool is_inline() const noexcept;
+    // Capacity to grow to so that at least required elements fit, as decided by the growth policy
+    size_t grow_capacity(size_t required) const;
+
 private:
     Allocator m_Allocator;
     size_t m_Capacity;
     size_t m_Size;
     T* m_Arr;
+    [[no_unique_address]] pysojic::vector_detail::InlineStorage<T, InlineCapacity> m_Inline;
 };
 
+// Vector storing up to N elements inline, without any allocation, and spilling to the heap through Allocator like
+// any Vector beyond that (same growth policy and relocation machinery). Meant for the many vectors that almost
+// always hold a handful of elements: no allocator traffic and the elements sit next to the rest of the owner.
+// The price: the object is N * sizeof(T) bigger, and moving a SmallVector whose elements are inline moves them one
+// by one (so pointers to them are not stable across moves).
+//
+//   SmallVector<Field, 8> fields; // no allocation until the 9th field
+template <typename T, size_t N, typename Allocator = std::allocator<T>,
+          typename GrowthPolicy = pysojic::vector_growth::Double>
+using SmallVector = Vector<T, Allocator, GrowthPolicy, N>;
+
 //------------Implementation--------------
 
-template <typename T, typename Allocator>
-Vector<T, Allocator>::Vector() 
-    : m_Capacity{1}, m_Size{0}, m_Arr{alloc::allocate(m_Allocator, m_Capacity)}
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+Vector<T, Allocator, GrowthPolicy, InlineCapacity>::Vector() 
+    : m_Capacity{InlineCapacity}, m_Size{0}
 {
+    m_Arr = m_Inline.data(); // nothing allocated until needed
 }
 
-template <typename T, typename Allocator>
-Vector<T, Allocator>::Vector(size_t size) 
-    : m_Capacity{size}, m_Size{0}, m_Arr{alloc::allocate(m_Allocator, m_Capacity)}
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+Vector<T, Allocator, GrowthPolicy, InlineCapacity>::Vector(size_t size) 
+    : m_Capacity{std::max(size, InlineCapacity)}, m_Size{0}, m_Arr{allocate(m_Capacity)}
 {
     try 
     {
+        if constexpr (DEFAULT_INIT)
+        {
+            std::uninitialized_default_construct_n(m_Arr, size);
+            m_Size = size;
+            return;
+        }
+
         // Could use std::uninitialized_default_construct_n for better readability and exception safety
         for (size_t i{}; i < size; ++i) 
         {
-            alloc::construct(m_Allocator, &m_Arr[m_Size++]); // default constructing
+            alloc::construct(m_Allocator, &m_Arr[m_Size]); // default constructing
+            ++m_Size;
         }
     } 
     catch (...) 
     {
         // If construction fails, clean up constructed elements and free memory.
         clear();
-        alloc::deallocate(m_Allocator, m_Arr, m_Capacity);
+        deallocate(m_Arr, m_Capacity);
         throw;
     }
 }
 
-template <typename T, typename Allocator>
-Vector<T, Allocator>::Vector(size_t size, const T& value) 
-    : m_Capacity{size}, m_Size{0}, m_Arr{alloc::allocate(m_Allocator, m_Capacity)}
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+Vector<T, Allocator, GrowthPolicy, InlineCapacity>::Vector(size_t size, pysojic::default_init_t)
+    : m_Capacity{std::max(size, InlineCapacity)}, m_Size{0}, m_Arr{allocate(m_Capacity)}
+{
+    try
+    {
+        // Bypasses the allocator's construct: it would value-initialize
+        std::uninitialized_default_construct_n(m_Arr, size);
+        m_Size = size;
+    }
+    catch (...)
+    {
+        // uninitialized_default_construct_n already destroyed what it had built
+        deallocate(m_Arr, m_Capacity);
+        throw;
+    }
+}
+
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+Vector<T, Allocator, GrowthPolicy, InlineCapacity>::Vector(size_t size, const T& value) 
+    : m_Capacity{std::max(size, InlineCapacity)}, m_Size{0}, m_Arr{allocate(m_Capacity)}
 {
     try 
     {
         for (size_t i{}; i < size; ++i) 
         {
             // Could use std::unitialized_fill for better readability and exception safety
-            alloc::construct(m_Allocator, &m_Arr[m_Size++], value);
+            alloc::construct(m_Allocator, &m_Arr[m_Size], value);
+            ++m_Size;
         }
     } 
     catch (...) 
     {
         clear();
-        alloc::deallocate(m_Allocator, m_Arr, m_Capacity);
+        deallocate(m_Arr, m_Capacity);
         throw;
     }
 }
 
-template <typename T, typename Allocator>
-Vector<T, Allocator>::Vector(std::initializer_list<T> init)
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+Vector<T, Allocator, GrowthPolicy, InlineCapacity>::Vector(std::initializer_list<T> init)
 {
     size_t size = init.size();
-    m_Capacity = size;
-    m_Arr = alloc::allocate(m_Allocator, m_Capacity);
+    m_Capacity = std::max(size, InlineCapacity);
+    m_Arr = allocate(m_Capacity);
     m_Size = 0;
 
     for (auto& elem : init)
     {
-        alloc::construct(m_Allocator, &m_Arr[m_Size++], elem);
+        alloc::construct(m_Allocator, &m_Arr[m_Size], elem);
+        ++m_Size;
     }
 }
 
-template <typename T, typename Allocator>
-Vector<T, Allocator>::Vector(const Vector<T, Allocator>& other) 
-    : m_Capacity{other.m_Capacity}, m_Size{0}, m_Arr{alloc::allocate(m_Allocator, m_Capacity)}
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+Vector<T, Allocator, GrowthPolicy, InlineCapacity>::Vector(const Vector<T, Allocator, GrowthPolicy, InlineCapacity>& other) 
+    : m_Capacity{other.m_Capacity}, m_Size{0}, m_Arr{allocate(m_Capacity)}
 {
     try 
     {
         for (size_t i{}; i < other.m_Size; ++i) 
         {
-            alloc::construct(m_Allocator, &m_Arr[m_Size++], other.m_Arr[i]);
+            alloc::construct(m_Allocator, &m_Arr[m_Size], other.m_Arr[i]);
+            ++m_Size;
         }
     } 
     catch (...) 
     {
         clear();
-        alloc::deallocate(m_Allocator, m_Arr, m_Capacity);
+        deallocate(m_Arr, m_Capacity);
         throw;
     }
 }
 
-template <typename T, typename Allocator>
-Vector<T, Allocator>& Vector<T, Allocator>::operator= (const Vector<T, Allocator>& other)
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+Vector<T, Allocator, GrowthPolicy, InlineCapacity>& Vector<T, Allocator, GrowthPolicy, InlineCapacity>::operator= (const Vector<T, Allocator, GrowthPolicy, InlineCapacity>& other)
 {
     if (this != &other)
     {
@@ -143,55 +310,65 @@ Vector<T, Allocator>& Vector<T, Allocator>::operator= (const Vector<T, Allocator
         // Remember that an object which has been moved from should be left in a valid state
         // this->~Vector();
         clear();
-        alloc::deallocate(m_Allocator, m_Arr, m_Capacity);
+        deallocate(m_Arr, m_Capacity);
 
         m_Capacity = other.m_Capacity;
         // m_Size = 0; // Not really needed since clear() was called
-        m_Arr = alloc::allocate(m_Allocator, m_Capacity);
+        m_Arr = allocate(m_Capacity);
         
         for (size_t i{}; i < other.m_Size; ++i) 
         {
-            alloc::construct(m_Allocator, &m_Arr[m_Size++], other.m_Arr[i]);
+            alloc::construct(m_Allocator, &m_Arr[m_Size], other.m_Arr[i]);
+            ++m_Size;
         }
     }
 
     return *this;
 }
 
-template <typename T, typename Allocator>
-Vector<T, Allocator>::Vector(Vector<T, Allocator>&& other) noexcept
-    : m_Arr{std::exchange(other.m_Arr, nullptr)}, m_Capacity{std::exchange(other.m_Capacity, 0)}, 
-    m_Size{std::exchange(other.m_Size, 0)}, m_Allocator{std::exchange(other.m_Allocator, nullptr)}
-{}
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+Vector<T, Allocator, GrowthPolicy, InlineCapacity>::Vector(Vector<T, Allocator, GrowthPolicy, InlineCapacity>&& other) noexcept(NOTHROW_TAKE)
+    : m_Allocator{std::move(other.m_Allocator)}, m_Capacity{InlineCapacity}, m_Size{0}
+{
+    m_Arr = m_Inline.data();
+    take(other);
+}
 
-template <typename T, typename Allocator>
-Vector<T, Allocator>& Vector<T, Allocator>::operator=(Vector<T, Allocator>&& other) noexcept
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+Vector<T, Allocator, GrowthPolicy, InlineCapacity>& Vector<T, Allocator, GrowthPolicy, InlineCapacity>::operator=(Vector<T, Allocator, GrowthPolicy, InlineCapacity>&& other) noexcept(NOTHROW_TAKE)
 {
     if (this != &other)
     {
         // Same problem as for the copy assignment operator, see above
         // this->~Vector();
         clear();
-        alloc::deallocate(m_Allocator, m_Arr, m_Capacity);
+        deallocate(m_Arr, m_Capacity);
 
+        m_Arr = m_Inline.data();
+        m_Capacity = InlineCapacity;
         // Steal resources
-        m_Arr = std::exchange(other.m_Arr, nullptr);
-        m_Capacity = std::exchange(other.m_Capacity, 0);
-        m_Size = std::exchange(other.m_Size, 0);
+        take(other);
     }
     return *this;
 }
 
-template <typename T, typename Allocator>
-Vector<T, Allocator>::~Vector() noexcept
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+Vector<T, Allocator, GrowthPolicy, InlineCapacity>::~Vector() noexcept
 {
     clear();
-    alloc::deallocate(m_Allocator, m_Arr, m_Capacity);
+    deallocate(m_Arr, m_Capacity);
 }
 
-template <typename T, typename Allocator>
-void Vector<T, Allocator>::clear() noexcept
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::clear() noexcept
 {
+    // Nothing to destroy, don't walk a whole I/O buffer to find out (it would, unoptimized)
+    if constexpr (std::is_trivially_destructible_v<T> && STD_ALLOCATOR)
+    {
+        m_Size = 0;
+        return;
+    }
+
     for (size_t i = 0; i < m_Size; ++i)
     {
         // m_Arr[i].~T(); Equivalent 
@@ -200,34 +377,37 @@ void Vector<T, Allocator>::clear() noexcept
     m_Size = 0;
 }
 
-template <typename T, typename Allocator>
-void Vector<T, Allocator>::push_back(const T& obj)
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::push_back(const T& obj)
 {
     if (m_Size >= m_Capacity)
-        reallocate(m_Capacity * 2);
+        reallocate(grow_capacity(m_Size + 1));
     
     // When you allocate raw memory with ::operator new, no objects are constructed in that memory. 
     // Directly assigning to m_Arr[m_Size] is essentially writing to uninitialized memory, 
     // which is undefined behavior—even if it appears to work in some cases.
     // m_Arr[m_Size++] = obj;
-    alloc::construct(m_Allocator, &m_Arr[m_Size++], obj);
+    // The size only grows once the element is built: if its constructor throws, there is nothing to destroy
+    alloc::construct(m_Allocator, &m_Arr[m_Size], obj);
+    ++m_Size;
 }
 
-template <typename T, typename Allocator>
-void Vector<T, Allocator>::push_back(T&& obj)
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::push_back(T&& obj)
 {
     if (m_Size >= m_Capacity)
-        reallocate(m_Capacity * 2);
+        reallocate(grow_capacity(m_Size + 1));
     
     // When you allocate raw memory with ::operator new, no objects are constructed in that memory. 
     // Directly assigning to m_Arr[m_Size] is essentially writing to uninitialized memory, 
     // which is undefined behavior—even if it appears to work in some cases.
     // m_Arr[m_Size++] = std::move(obj);
-    alloc::construct(m_Allocator, &m_Arr[m_Size++], std::move(obj));
+    alloc::construct(m_Allocator, &m_Arr[m_Size], std::move(obj));
+    ++m_Size;
 }
 
-template <typename T, typename Allocator>
-void Vector<T, Allocator>::pop_back() noexcept
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::pop_back() noexcept
 {
     if (m_Size > 0)
     {
@@ -236,33 +416,45 @@ void Vector<T, Allocator>::pop_back() noexcept
     }
 }
 
-template<typename T, typename Allocator>
+template<typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
 template<typename... Args>
-void Vector<T, Allocator>::emplace_back(Args&&... args)
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::emplace_back(Args&&... args)
 {
     if (m_Size >= m_Capacity)
-        reallocate(m_Capacity * 2);
+        reallocate(grow_capacity(m_Size + 1));
 
-    alloc::construct(m_Allocator, &m_Arr[m_Size++], std::forward<Args>(args)...);
+    alloc::construct(m_Allocator, &m_Arr[m_Size], std::forward<Args>(args)...);
+    ++m_Size;
 }
 
-template <typename T, typename Allocator>
-void Vector<T, Allocator>::shrink_to_fit()
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::shrink_to_fit()
 {
     if (m_Size == 0)
     {
-        reallocate(1);
+        deallocate(m_Arr, m_Capacity);
+        m_Arr = m_Inline.data();
+        m_Capacity = InlineCapacity;
         return;
     }
-    reallocate(m_Size);    
+    // A small vector never goes below its inline capacity (and moves back inline if the elements fit)
+    size_t newCapacity = std::max(m_Size, InlineCapacity);
+    if (newCapacity != m_Capacity)
+        reallocate(newCapacity);
 }
 
-template <typename T, typename Allocator>
-void Vector<T, Allocator>::resize(size_t newSize)
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::resize(size_t newSize)
 {
+    if constexpr (DEFAULT_INIT)
+    {
+        resize(newSize, pysojic::default_init);
+        return;
+    }
+
     if (newSize > m_Size)
     {
-        if (newSize < m_Capacity)
+        if (newSize <= m_Capacity)
         {
             for (size_t i = m_Size; i < newSize; ++i)
             {
@@ -271,7 +463,7 @@ void Vector<T, Allocator>::resize(size_t newSize)
         }   
         else
         {
-            reallocate(newSize + (newSize >> 1));
+            reallocate(grow_capacity(newSize));
             for (size_t i = m_Size; i < newSize; ++i)
             {
                 alloc::construct(m_Allocator, &m_Arr[i]);
@@ -281,7 +473,7 @@ void Vector<T, Allocator>::resize(size_t newSize)
     
     if (newSize < m_Size)
     {
-        for (size_t i = m_Size - 1; i > newSize - 1; --i)
+        for (size_t i = newSize; i < m_Size; ++i)
         {
             //m_Arr[i].~T();
             alloc::destroy(m_Allocator, &m_Arr[i]);
@@ -291,15 +483,84 @@ void Vector<T, Allocator>::resize(size_t newSize)
     m_Size = newSize;
 }
 
-template <typename T, typename Allocator>
-void Vector<T, Allocator>::reserve(size_t newCapacity)
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::resize(size_t newSize, pysojic::default_init_t)
+{
+    if (newSize > m_Size)
+    {
+        if (newSize > m_Capacity)
+            reallocate(grow_capacity(newSize));
+        // Compiles to nothing for trivial T: the new elements keep whatever bytes the memory held. If a constructor
+        // throws, the ones already built are destroyed and the size is unchanged.
+        std::uninitialized_default_construct_n(m_Arr + m_Size, newSize - m_Size);
+    }
+
+    for (size_t i = newSize; i < m_Size; ++i)
+        alloc::destroy(m_Allocator, &m_Arr[i]);
+
+    m_Size = newSize;
+}
+
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::reserve(size_t newCapacity)
 {
     if (newCapacity > m_Capacity)
         reallocate(newCapacity);
 }
 
-template <typename T, typename Allocator>
-void Vector<T, Allocator>::print() const 
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+template <std::input_iterator InputIt>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::append(InputIt first, InputIt last)
+{
+    insert_range(m_Size, std::ranges::subrange(std::move(first), std::move(last)));
+}
+
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+template <std::ranges::input_range R>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::insert_range(size_t pos, R&& range)
+{
+    size_t oldSize = m_Size;
+    try
+    {
+        if constexpr (std::ranges::forward_range<R> || std::ranges::sized_range<R>)
+        {
+            // Grow once to the final size, then construct in place without checking the capacity per element
+            size_t count = static_cast<size_t>(std::ranges::distance(range));
+            if (count > alloc::max_size(m_Allocator) - m_Size)
+                throw std::length_error("Vector: size exceeds max_size()");
+            if (m_Size + count > m_Capacity)
+                reallocate(grow_capacity(m_Size + count));
+
+            for (auto&& elem : range)
+            {
+                alloc::construct(m_Allocator, &m_Arr[m_Size], std::forward<decltype(elem)>(elem));
+                ++m_Size;
+            }
+        }
+        else
+        {
+            // Single pass and no size: the count is only known at the end
+            for (auto&& elem : range)
+                emplace_back(std::forward<decltype(elem)>(elem));
+        }
+    }
+    catch (...)
+    {
+        // Nothing inserted if an element fails to construct
+        for (size_t i = oldSize; i < m_Size; ++i)
+            alloc::destroy(m_Allocator, &m_Arr[i]);
+        m_Size = oldSize;
+        throw;
+    }
+
+    // The new elements were built at the end, bring them in front of [pos, oldSize). Each element is moved about
+    // once, as many moves as shifting the tail to make room first, but the shift would need the count up front.
+    if (pos < oldSize)
+        std::rotate(m_Arr + pos, m_Arr + oldSize, m_Arr + m_Size);
+}
+
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::print() const 
 {
     for (size_t i = 0; i < m_Size; ++i )
     {
@@ -310,20 +571,160 @@ void Vector<T, Allocator>::print() const
 }
 
 
-template <typename T, typename Allocator>
-void Vector<T, Allocator>::reallocate(size_t newCapacity)
-{                 
-    T* ptr = alloc::allocate(m_Allocator, newCapacity);
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+T* Vector<T, Allocator, GrowthPolicy, InlineCapacity>::allocate(size_t n)
+{
+    // Only ever asked while the inline buffer is unused (m_Arr is elsewhere or about to be released)
+    if constexpr (InlineCapacity != 0)
+    {
+        if (n <= InlineCapacity)
+            return m_Inline.data();
+    }
 
-    for (size_t i = 0; i < m_Size; ++i)
+    if constexpr (USE_REALLOC)
     {
-        // ptr[i] = std::move(m_Arr[i]); // Does not work, ptr[i] is unassigned memory, cannot move assign on unitialized memory
-        alloc::construct(m_Allocator, &ptr[i], std::move(m_Arr[i]));
-        // m_Arr[i].~T(); Equivalent to line below
-        alloc::destroy(m_Allocator, &m_Arr[i]);
+        if (n > SIZE_MAX / sizeof(T))
+            throw std::bad_array_new_length();
+        void* ptr = std::malloc(n * sizeof(T));
+        if (!ptr && n != 0)
+            throw std::bad_alloc();
+        return static_cast<T*>(ptr);
+    }
+    else
+    {
+        // An empty Vector holds no buffer at all
+        return n != 0 ? alloc::allocate(m_Allocator, n) : nullptr;
     }
+}
 
-    alloc::deallocate(m_Allocator, m_Arr, m_Capacity);
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+size_t Vector<T, Allocator, GrowthPolicy, InlineCapacity>::grow_capacity(size_t required) const
+{
+    size_t maxSize = alloc::max_size(m_Allocator);
+    if (required > maxSize)
+        throw std::length_error("Vector: size exceeds max_size()");
+    return std::min(GrowthPolicy::next_capacity(m_Capacity, required, sizeof(T)), maxSize);
+}
+
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::deallocate(T* ptr, size_t n) noexcept
+{
+    if constexpr (InlineCapacity != 0)
+    {
+        if (ptr == m_Inline.data())
+            return;
+    }
+
+    if constexpr (USE_REALLOC)
+        std::free(ptr);
+    else if (ptr)
+        alloc::deallocate(m_Allocator, ptr, n);
+}
+
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::reallocate(size_t newCapacity)
+{                 
+    if constexpr (USE_REALLOC)
+    {
+        // realloc only moves a heap block to a heap block (not from/to the inline buffer of a small vector)
+        if (InlineCapacity == 0 || (!is_inline() && newCapacity > InlineCapacity))
+        {
+            if (newCapacity > SIZE_MAX / sizeof(T))
+                throw std::bad_array_new_length();
+            // realloc keeps the first m_Size elements (their bytes are all a trivially relocatable type needs)
+            void* ptr = std::realloc(static_cast<void*>(m_Arr), (newCapacity != 0 ? newCapacity : 1) * sizeof(T));
+            if (!ptr)
+                throw std::bad_alloc(); // m_Arr is left untouched
+            m_Capacity = newCapacity;
+            m_Arr = static_cast<T*>(ptr);
+            return;
+        }
+    }
+
+    T* ptr = allocate(newCapacity);
+    try
+    {
+        relocate(m_Arr, ptr);
+    }
+    catch (...)
+    {
+        deallocate(ptr, newCapacity); // m_Arr still holds the elements
+        throw;
+    }
+    deallocate(m_Arr, m_Capacity);
     m_Capacity = newCapacity;
     m_Arr = ptr;
+}
+
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::relocate(T* src, T* dest) noexcept(NOTHROW_RELOCATE)
+{
+    if constexpr (pysojic::is_trivially_relocatable_v<T>)
+    {
+        // Moving the bytes and forgetting the originals is the same as move-constructing + destroying one by one
+        pysojic::relocate_n(src, m_Size, dest);
+    }
+    else if constexpr (std::is_nothrow_move_constructible_v<T>)
+    {
+        for (size_t i = 0; i < m_Size; ++i)
+        {
+            // dest[i] = std::move(src[i]); // Does not work, dest[i] is unassigned memory, cannot move assign on unitialized memory
+            alloc::construct(m_Allocator, &dest[i], std::move(src[i]));
+            // src[i].~T(); Equivalent to line below
+            alloc::destroy(m_Allocator, &src[i]);
+        }
+    }
+    else
+    {
+        // Copy (unless T is move-only), and destroy the originals only once every element made it
+        size_t i = 0;
+        try
+        {
+            for (; i < m_Size; ++i)
+                alloc::construct(m_Allocator, &dest[i], std::move_if_noexcept(src[i]));
+        }
+        catch (...)
+        {
+            while (i > 0)
+                alloc::destroy(m_Allocator, &dest[--i]);
+            throw;
+        }
+
+        for (i = 0; i < m_Size; ++i)
+            alloc::destroy(m_Allocator, &src[i]);
+    }
+}
+
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+void Vector<T, Allocator, GrowthPolicy, InlineCapacity>::take(Vector& other) noexcept(NOTHROW_TAKE)
+{
+    if (other.is_inline())
+    {
+        // The buffer is part of other: the elements have to move, into this one's inline buffer (same capacity)
+        other.relocate(other.m_Arr, m_Arr);
+        m_Size = std::exchange(other.m_Size, 0);
+        return;
+    }
+
+    m_Arr = std::exchange(other.m_Arr, other.m_Inline.data());
+    m_Capacity = std::exchange(other.m_Capacity, InlineCapacity);
+    m_Size = std::exchange(other.m_Size, 0);
+}
+
+template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+bool Vector<T, Allocator, GrowthPolicy, InlineCapacity>::is_inline() const noexcept
+{
+    if constexpr (InlineCapacity != 0)
+        return static_cast<const void*>(m_Arr) == static_cast<const void*>(m_Inline.m_Data);
+    else
+        return false;
+}
+
+namespace pysojic
+{
+    // A Vector is a pointer to its elements plus sizes: its bytes can move as long as the allocator's can.
+    // Not a small vector, whose pointer may point into the object itself.
+    template <typename T, typename Allocator, typename GrowthPolicy, size_t InlineCapacity>
+    struct is_trivially_relocatable<Vector<T, Allocator, GrowthPolicy, InlineCapacity>>
+        : std::bool_constant<InlineCapacity == 0 && is_trivially_relocatable<Allocator>::value> {};
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+
+#include "Containers/SPSCQueue.hpp"
+#include "Concurrency/WaitStrategy.hpp"
+
+// SPSCQueue whose consumer can block until there is something to consume, instead of spinning on pop().
+// How it waits is the WaitStrategy (see Concurrency/WaitStrategy.hpp): BusySpinWait / PauseSpinWait for the lowest
+// latency when a core can be dedicated to the consumer, ParkingWait (default) to use no CPU while the queue is idle.
+// The producer side never blocks: push() still returns false when the queue is full.
+//
+// close() lets the consumer exit: once the queue is closed and drained, the blocking calls return false/nullptr.
+//
+//   pysojic::WaitableSPSCQueue<Order, 4096> queue;
+//   // consumer thread
+//   Order order;
+//   while (queue.pop(order))    // sleeps while the queue is empty
+//       handle(order);
+//   // producer thread
+//   queue.push(order);
+//   ...
+//   queue.close();
+namespace pysojic
+{
+    template <typename T, std::size_t Capacity, typename WaitStrategy = ParkingWait, typename Allocator = std::allocator<T>>
+    class WaitableSPSCQueue
+    {
+    public:
+        WaitableSPSCQueue() requires (Capacity != std::dynamic_extent) = default;
+        explicit WaitableSPSCQueue(std::size_t capacity, const Allocator& allocator = Allocator())
+            requires (Capacity == std::dynamic_extent)
+            : m_Queue{capacity, allocator}
+        {
+        }
+
+        // Producer side: same as SPSCQueue, plus waking up the consumer
+
+        template <typename... Args>
+        bool emplace(Args&&... args)
+        {
+            bool pushed = m_Queue.emplace(std::forward<Args>(args)...);
+            if (pushed)
+                m_Wait.notify();
+            return pushed;
+        }
+        bool push(const T& value) { return emplace(value); }
+        bool push(T&& value) { return emplace(std::move(value)); }
+
+        std::size_t push_n(std::span<const T> values)
+        {
+            std::size_t pushed = m_Queue.push_n(values);
+            if (pushed != 0)
+                m_Wait.notify();
+            return pushed;
+        }
+
+        /// No more elements will be pushed: wakes the consumer up, which drains what is left and then stops waiting
+        void close() noexcept
+        {
+            m_Closed.store(true, std::memory_order_release);
+            m_Wait.notify();
+        }
+
+        // Consumer side, blocking
+
+        /// Wait for an element and move it into out. Returns false if the queue was closed and is empty.
+        bool pop(T& out)
+        {
+            wait_for_data();
+            return m_Queue.pop(out);
+        }
+
+        /// Wait for an element and return a pointer to it (release it with pop()), nullptr if closed and empty
+        T* wait_front()
+        {
+            wait_for_data();
+            return m_Queue.front();
+        }
+
+        /// Wait for at least one element, then call f(T&) on every element present (see SPSCQueue::try_consume_all).
+        /// Returns 0 if the queue was closed and is empty.
+        template <typename F>
+        std::size_t consume_all(F&& f)
+        {
+            wait_for_data();
+            return m_Queue.try_consume_all(std::forward<F>(f));
+        }
+
+        // Consumer side, non-blocking
+
+        bool try_pop(T& out) { return m_Queue.pop(out); }
+        T* front() noexcept { return m_Queue.front(); }
+        void pop() noexcept { m_Queue.pop(); }
+        std::size_t pop_n(std::span<T> out) { return m_Queue.pop_n(out); }
+        template <typename F>
+        std::size_t try_consume_all(F&& f) { return m_Queue.try_consume_all(std::forward<F>(f)); }
+
+        std::size_t size() const noexcept { return m_Queue.size(); }
+        bool empty() const noexcept { return m_Queue.empty(); }
+        constexpr std::size_t capacity() const noexcept { return m_Queue.capacity(); }
+        bool closed() const noexcept { return m_Closed.load(std::memory_order_acquire); }
+
+    private:
+        void wait_for_data()
+        {
+            m_Wait.wait([this] { return m_Queue.front() != nullptr || m_Closed.load(std::memory_order_acquire); });
+        }
+
+    private:
+        SPSCQueue<T, Capacity, Allocator> m_Queue;
+        WaitStrategy m_Wait;
+        // Written once, but polled by a spinning consumer: kept off the producer's cache line
+        alignas(64) std::atomic<bool> m_Closed{false};
+    };
+}
@@ -6,6 +6,8 @@
 #include <memory>
 #include <cstddef>
 
+#include "Utilities/Relocation.hpp"
+
 /*
 I intentionally didn’t implement a fully type-erased deleter for this SharedPtr implementation. 
 For most interview settings (especially non-senior), that level of generality is rarely expected, 
@@ -232,4 +234,8 @@ namespace pysojic
         }
     }
 
+    // The control block is shared by address, but nothing points back to the SharedPtr itself: relocating one copies
+    // its two pointers and leaves the reference count alone (see Utilities/Relocation.hpp)
+    template <typename T>
+    struct is_trivially_relocatable<SharedPtr<T>> : std::true_type {};
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <string>
 #include <iostream>
 
+#include "Utilities/Relocation.hpp"
+
 template <typename T>
 struct DefaultDeleter
 {
@@ -114,4 +116,9 @@ namespace pysojic
         // in std::forward, the ... after means to unpack the params
         return UniquePtr<T>(new T{std::forward<Args>(args)...});
     };
+
+    // Only a pointer (and the deleter): a moved-from UniquePtr holds nullptr, so moving the bytes elsewhere and
+    // forgetting the original is the same as a move + destroy (see Utilities/Relocation.hpp)
+    template <typename T, typename Deleter>
+    struct is_trivially_relocatable<UniquePtr<T, Deleter>> : is_trivially_relocatable<Deleter> {};
 }
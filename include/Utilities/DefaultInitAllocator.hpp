@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Utilities/Relocation.hpp"
+
+// Default-initialization for container elements.
+//
+// Containers build their elements with allocator_traits::construct(alloc, ptr), which value-initializes: a
+// Vector<uint8_t>(1 << 30) zero-fills a whole gigabyte, one full pass over memory (and a page fault per 4KB page)
+// just before the buffer gets overwritten by read()/recv()/memcpy anyway. Default-initialization (`new (ptr) T`,
+// without the parentheses) leaves trivial types such as integers, floats and PODs uninitialized and is free, while
+// still running the default constructor of every other type.
+//
+// Two ways to ask for it:
+//   - per call, with the default_init tag: Vector<uint8_t> buffer(size, pysojic::default_init),
+//     buffer.resize(size, pysojic::default_init) or buffer.resize_uninitialized(size)
+//   - for every element of a container, with the DefaultInitAllocator adaptor below:
+//     Vector<uint8_t, pysojic::DefaultInitAllocator<uint8_t>> buffer(size);
+// Reading the new elements before writing them is undefined behaviour (indeterminate values).
+namespace pysojic
+{
+    struct default_init_t
+    {
+        explicit default_init_t() = default;
+    };
+
+    inline constexpr default_init_t default_init{};
+
+    // Allocator adaptor whose construct() without arguments default-initializes instead of value-initializing.
+    // Everything else (allocation, construction with arguments) is Allocator's.
+    template <typename T, typename Allocator = std::allocator<T>>
+    class DefaultInitAllocator : public Allocator
+    {
+        using traits = std::allocator_traits<Allocator>;
+
+    public:
+        template <typename U>
+        struct rebind
+        {
+            using other = DefaultInitAllocator<U, typename traits::template rebind_alloc<U>>;
+        };
+
+        using Allocator::Allocator;
+        DefaultInitAllocator() = default;
+        template <typename U, typename OtherAllocator>
+        DefaultInitAllocator(const DefaultInitAllocator<U, OtherAllocator>& other) noexcept
+            : Allocator(static_cast<const OtherAllocator&>(other))
+        {
+        }
+
+        template <typename U>
+        void construct(U* ptr) noexcept(std::is_nothrow_default_constructible_v<U>)
+        {
+            ::new (static_cast<void*>(ptr)) U;
+        }
+
+        template <typename U, typename... Args>
+        void construct(U* ptr, Args&&... args)
+        {
+            traits::construct(static_cast<Allocator&>(*this), ptr, std::forward<Args>(args)...);
+        }
+    };
+
+    template <typename A>
+    struct is_default_init_allocator : std::false_type {};
+    template <typename T, typename Allocator>
+    struct is_default_init_allocator<DefaultInitAllocator<T, Allocator>> : std::true_type {};
+
+    template <typename A>
+    inline constexpr bool is_default_init_allocator_v = is_default_init_allocator<A>::value;
+
+    // Holds nothing but the underlying allocator
+    template <typename T, typename Allocator>
+    struct is_trivially_relocatable<DefaultInitAllocator<T, Allocator>> : is_trivially_relocatable<Allocator> {};
+}
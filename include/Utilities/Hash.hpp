@@ -0,0 +1,243 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace pysojic
+{
+    // Transparent hasher for string keys: std::string, std::string_view and const char* all hash to the same value
+    // (the standard guarantees hash<string>(s) == hash<string_view>(s)), so a map keyed by std::string can be queried
+    // with a string_view parsed off the wire without building a temporary std::string.
+    // Use it together with std::equal_to<> as the key comparator, e.g.
+    //   pysojic::HashMap<std::string, int, pysojic::StringHash, std::equal_to<>>
+    struct StringHash
+    {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view sv) const noexcept
+        {
+            return std::hash<std::string_view>{}(sv);
+        }
+    };
+
+    // Same rule as the standard unordered containers (C++20): heterogeneous lookup is only enabled when both
+    // the hasher and the comparator opt in, since they have to agree on how a K relates to a Key.
+    template <typename HashFunction, typename KeyEqual>
+    concept TransparentHash = requires
+    {
+        typename HashFunction::is_transparent;
+        typename KeyEqual::is_transparent;
+    };
+
+    //------------ Mixers ------------
+    // The maps index their power-of-two tables with hash & (size - 1), i.e. only the low bits of the hash are used.
+    // libstdc++'s std::hash<integer> is the identity, so sequential ids or keys that are multiples of a power of two
+    // land in neighbouring (or identical) slots, which is the worst case for linear probing.
+    // A mixer (or finalizer) scrambles the bits so that every input bit affects every output bit.
+
+    // 64-bit finalizer of MurmurHash3: 2 multiplies and 3 xor-shifts, full avalanche
+    constexpr std::uint64_t fmix64(std::uint64_t h) noexcept
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // Fibonacci hashing (Knuth): multiply by 2^64 / golden ratio and keep the top `bits` bits (1 <= bits <= 64).
+    // The high bits of the product depend on every bit of x, the low ones don't.
+    constexpr std::uint64_t fibonacci_hash(std::uint64_t x, int bits) noexcept
+    {
+        return (x * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+    }
+
+    namespace hash_detail
+    {
+#if defined(__SIZEOF_INT128__)
+        __extension__ typedef unsigned __int128 uint128;
+#endif
+
+        // Full 64x64 -> 128-bit product: a receives the low half, b the high half
+        constexpr void mul128(std::uint64_t& a, std::uint64_t& b) noexcept
+        {
+#if defined(__SIZEOF_INT128__)
+            uint128 r = static_cast<uint128>(a) * b;
+            a = static_cast<std::uint64_t>(r);
+            b = static_cast<std::uint64_t>(r >> 64);
+#else
+            std::uint64_t ha = a >> 32, la = static_cast<std::uint32_t>(a);
+            std::uint64_t hb = b >> 32, lb = static_cast<std::uint32_t>(b);
+            std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+            std::uint64_t t = rl + (rm0 << 32);
+            std::uint64_t carry = t < rl;
+            std::uint64_t lo = t + (rm1 << 32);
+            carry += lo < t;
+            a = lo;
+            b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+        }
+
+        // The "mum" mixing primitive of wyhash: low ^ high half of the product
+        constexpr std::uint64_t mum(std::uint64_t a, std::uint64_t b) noexcept
+        {
+            mul128(a, b);
+            return a ^ b;
+        }
+
+        // Little-endian loads. Constant evaluation cannot reinterpret bytes, so it assembles them one at a time.
+        template <int N>
+        constexpr std::uint64_t read_le(const char* p) noexcept
+        {
+            if consteval
+            {
+                std::uint64_t v = 0;
+                for (int i = N - 1; i >= 0; --i)
+                    v = (v << 8) | static_cast<unsigned char>(p[i]);
+                return v;
+            }
+            else
+            {
+                std::conditional_t<N == 8, std::uint64_t, std::uint32_t> v;
+                std::memcpy(&v, p, N);
+                if constexpr (std::endian::native == std::endian::big)
+                    v = std::byteswap(v);
+                return v;
+            }
+        }
+
+        constexpr std::uint64_t read8(const char* p) noexcept { return read_le<8>(p); }
+        constexpr std::uint64_t read4(const char* p) noexcept { return read_le<4>(p); }
+
+        inline constexpr std::uint64_t wy_secret[4] = {0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+                                                       0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL};
+    }
+
+    // wyhash (https://github.com/wangyi-fudan/wyhash, final version 4) over a byte string: 16 bytes per 128-bit
+    // multiply, and strings up to 16 bytes are read with a few overlapping loads without any loop.
+    // On par with libstdc++'s std::hash<string> (murmur-based) on short keys, about twice as fast from 32 bytes on,
+    // and usable in constant expressions.
+    constexpr std::uint64_t wyhash(std::string_view s, std::uint64_t seed = 0) noexcept
+    {
+        using namespace hash_detail;
+
+        const char* p = s.data();
+        size_t len = s.size();
+        std::uint64_t a = 0, b = 0;
+        seed ^= mum(seed ^ wy_secret[0], wy_secret[1]);
+
+        if (len <= 16)
+        {
+            if (len >= 4)
+            {
+                a = (read4(p) << 32) | read4(p + ((len >> 3) << 2));
+                b = (read4(p + len - 4) << 32) | read4(p + len - 4 - ((len >> 3) << 2));
+            }
+            else if (len > 0)
+            {
+                a = (std::uint64_t{static_cast<unsigned char>(p[0])} << 16) |
+                    (std::uint64_t{static_cast<unsigned char>(p[len >> 1])} << 8) | static_cast<unsigned char>(p[len - 1]);
+            }
+        }
+        else
+        {
+            size_t i = len;
+            if (i > 48)
+            {
+                std::uint64_t see1 = seed, see2 = seed;
+                do
+                {
+                    seed = mum(read8(p) ^ wy_secret[1], read8(p + 8) ^ seed);
+                    see1 = mum(read8(p + 16) ^ wy_secret[2], read8(p + 24) ^ see1);
+                    see2 = mum(read8(p + 32) ^ wy_secret[3], read8(p + 40) ^ see2);
+                    p += 48;
+                    i -= 48;
+                } while (i > 48);
+                seed ^= see1 ^ see2;
+            }
+            while (i > 16)
+            {
+                seed = mum(read8(p) ^ wy_secret[1], read8(p + 8) ^ seed);
+                i -= 16;
+                p += 16;
+            }
+            a = read8(p + i - 16);
+            b = read8(p + i - 8);
+        }
+
+        a ^= wy_secret[1];
+        b ^= seed;
+        mul128(a, b);
+        return mum(a ^ wy_secret[0] ^ len, b ^ wy_secret[1]);
+    }
+
+    //------------ Hash policies ------------
+    // Drop-in replacements for std::hash as the HashFunction parameter of the maps.
+
+    // Integers, enums and pointers through the Murmur finalizer
+    struct MurmurHash
+    {
+        template <typename T> requires std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>
+        constexpr std::size_t operator()(T key) const noexcept
+        {
+            if constexpr (std::is_pointer_v<T>)
+                return fmix64(reinterpret_cast<std::uintptr_t>(key));
+            else
+                return fmix64(static_cast<std::uint64_t>(key));
+        }
+    };
+
+    // Cheaper than MurmurHash (a single multiply), good enough for sequential ids. The high half of the product is
+    // folded into the low half since the tables only look at the low bits.
+    struct FibonacciHash
+    {
+        template <typename T> requires std::is_integral_v<T> || std::is_enum_v<T>
+        constexpr std::size_t operator()(T key) const noexcept
+        {
+            std::uint64_t h = static_cast<std::uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+            return h ^ (h >> 32);
+        }
+    };
+
+    // Transparent like StringHash (use it with std::equal_to<>), but with wyhash
+    struct WyHash
+    {
+        using is_transparent = void;
+
+        constexpr std::size_t operator()(std::string_view sv) const noexcept
+        {
+            return wyhash(sv);
+        }
+    };
+
+    //------------ Weak hash guard ------------
+    // A hasher is "weak" when its low bits are not well distributed, e.g. std::hash<integer> (the identity) or
+    // std::hash<T*> (pointers are aligned, their low bits are always 0). The maps post-mix the result of weak hashers
+    // with fmix64 at compile time (see mixed_hash), and pay nothing for good ones.
+    // Specialize IsWeakHash for your own hashers if needed.
+    template <typename HashFunction>
+    struct IsWeakHash : std::false_type {};
+
+    template <typename T>
+    struct IsWeakHash<std::hash<T>> : std::bool_constant<std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>> {};
+
+    template <typename HashFunction>
+    inline constexpr bool is_weak_hash_v = IsWeakHash<HashFunction>::value;
+
+    // What the power-of-two maps use to hash a key
+    template <typename HashFunction, typename K>
+    constexpr std::size_t mixed_hash(const K& key) noexcept(noexcept(HashFunction{}(key)))
+    {
+        if constexpr (is_weak_hash_v<HashFunction>)
+            return fmix64(HashFunction{}(key));
+        else
+            return HashFunction{}(key);
+    }
+}
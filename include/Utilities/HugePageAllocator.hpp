@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+// Allocator handing out memory backed by 2MB huge pages.
+// With 4KB pages, every 4KB of a big buffer needs its own TLB entry: walking a 64MB ring touches 16384 pages,
+// far more than the TLB holds, so a good part of the accesses pay a page walk. With 2MB pages the same ring is 32
+// entries. It is meant for a few big, long-lived buffers (queue rings, tables): every allocation is rounded up to
+// a multiple of 2MB and goes straight to mmap.
+//
+// On Linux it tries, in order:
+//   - MAP_HUGETLB: pages from the reserved huge page pool (vm.nr_hugepages), guaranteed to be huge.
+//   - A regular mapping aligned on 2MB with madvise(MADV_HUGEPAGE): transparent huge pages, which the kernel
+//     uses when THP is set to "always" or "madvise" and it finds free 2MB blocks (falls back to 4KB pages
+//     silently otherwise).
+// Elsewhere it allocates 2MB-aligned memory with operator new, which at least lets the OS use large pages if it
+// does so on its own.
+namespace pysojic
+{
+    inline constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+
+    namespace huge_page_detail
+    {
+        constexpr size_t round_up(size_t bytes) noexcept
+        {
+            return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        }
+
+        void* allocate(size_t bytes);
+        void deallocate(void* ptr, size_t bytes) noexcept;
+    }
+
+    template <typename T>
+    class HugePageAllocator
+    {
+    public:
+        using value_type = T;
+
+        HugePageAllocator() noexcept = default;
+        template <typename U>
+        HugePageAllocator(const HugePageAllocator<U>&) noexcept {}
+
+        T* allocate(size_t n)
+        {
+            // (room left for rounding up to the huge page size and for the alignment slack)
+            if (n > (SIZE_MAX - 2 * HUGE_PAGE_SIZE) / sizeof(T))
+                throw std::bad_array_new_length();
+            return static_cast<T*>(huge_page_detail::allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T* ptr, size_t n) noexcept
+        {
+            huge_page_detail::deallocate(ptr, n * sizeof(T));
+        }
+
+        // Stateless: memory allocated by any instance can be freed by any other
+        template <typename U>
+        bool operator==(const HugePageAllocator<U>&) const noexcept { return true; }
+    };
+
+    //------------ Implementation ------------
+
+#if defined(__linux__)
+    inline void* huge_page_detail::allocate(size_t bytes)
+    {
+        bytes = round_up(bytes);
+
+        void* ptr;
+#if defined(MAP_HUGETLB)
+        ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED)
+            return ptr;
+#endif
+
+        // Transparent huge pages only back 2MB-aligned 2MB ranges, and mmap only aligns on 4KB: map one huge page
+        // more than needed and unmap what sticks out on both sides of the aligned range
+        void* raw = ::mmap(nullptr, bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            throw std::bad_alloc();
+
+        auto begin = reinterpret_cast<std::uintptr_t>(raw);
+        auto aligned = (begin + HUGE_PAGE_SIZE - 1) & ~(std::uintptr_t{HUGE_PAGE_SIZE} - 1);
+        if (aligned != begin)
+            ::munmap(raw, aligned - begin);
+        if (size_t tail = begin + HUGE_PAGE_SIZE - aligned; tail != 0)
+            ::munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+
+        ptr = reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE)
+        ::madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+        return ptr;
+    }
+
+    // Both kinds of mapping are released the same way (for MAP_HUGETLB the length is a multiple of the huge page
+    // size, which round_up guarantees)
+    inline void huge_page_detail::deallocate(void* ptr, size_t bytes) noexcept
+    {
+        ::munmap(ptr, round_up(bytes));
+    }
+#else
+    inline void* huge_page_detail::allocate(size_t bytes)
+    {
+        return ::operator new(round_up(bytes), std::align_val_t{HUGE_PAGE_SIZE});
+    }
+
+    inline void huge_page_detail::deallocate(void* ptr, size_t) noexcept
+    {
+        ::operator delete(ptr, std::align_val_t{HUGE_PAGE_SIZE});
+    }
+#endif
+}
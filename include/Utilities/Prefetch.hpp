@@ -0,0 +1,22 @@
+#pragma once
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <xmmintrin.h>
+#endif
+
+namespace pysojic
+{
+    // Software prefetch: ask the CPU to start loading the cache line holding ptr without waiting for it.
+    // It never faults (any address is fine), and is only worth it when there is independent work to do in the
+    // meantime, e.g. hashing/prefetching the next keys of a batch while the first slots are on their way.
+    inline void prefetch_read(const void* ptr) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(ptr, 0, 3);
+#elif defined(_MSC_VER)
+        _mm_prefetch(static_cast<const char*>(ptr), _MM_HINT_T0);
+#else
+        (void)ptr;
+#endif
+    }
+}
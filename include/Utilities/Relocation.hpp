@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+// Relocation = move-construct an object to a new address, then destroy the original. Containers do it all the time
+// (a Vector growing moves every element to the new buffer), one element at a time.
+//
+// For most types the two steps together amount to copying the bytes: a UniquePtr moved then destroyed leaves a
+// nullptr behind that the destructor ignores, so copying its pointer and forgetting the original has the same
+// effect. Such types are "trivially relocatable" (see P1144, and folly / Qt / BSL which rely on the same property)
+// and a whole array of them can be relocated with a single memcpy, or even by realloc without touching the
+// elements at all.
+//
+// What breaks it is an object pointing into itself (e.g. std::string implementations keeping a pointer to their own
+// SSO buffer, or intrusive list nodes) or registered somewhere by address. Hence it is opt-in: the default only
+// covers trivially copyable types, others specialize the trait next to their definition:
+//
+//   namespace pysojic
+//   {
+//       template <> struct is_trivially_relocatable<MyType> : std::true_type {};
+//   }
+namespace pysojic
+{
+    template <typename T>
+    struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+    // Stateless, but not trivially copyable (it has user-provided copy constructors)
+    template <typename T>
+    struct is_trivially_relocatable<std::allocator<T>> : std::true_type {};
+
+    template <typename T>
+    inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<std::remove_cv_t<T>>::value;
+
+    // Relocate the n objects at src into the uninitialized storage at dest (no overlap): afterwards the objects live
+    // at dest, and src is raw memory that must not be destroyed
+    template <typename T>
+    void relocate_n(T* src, size_t n, T* dest) noexcept
+    {
+        static_assert(is_trivially_relocatable_v<T>, "T is not trivially relocatable");
+        if (n != 0)
+            std::memcpy(static_cast<void*>(dest), static_cast<const void*>(src), n * sizeof(T));
+    }
+}
@@ -0,0 +1,819 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PYSOJIC_SIMD_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+// Vectorized reductions and searches over contiguous float / double / int32 data (Vector, Array, std::span, ...):
+// sum, min, max, find, count and dot.
+//
+// Compilers do vectorize such loops on their own, but not reliably: never at -O0 (our default build), and never a
+// floating-point reduction without -ffast-math, since adding in a different order changes the result. These
+// kernels do it explicitly, with several accumulators to hide the latency of the adds.
+//
+// Each operation has an AVX-512, an AVX2 and a scalar kernel, the best one the CPU supports is picked at runtime
+// (cpuid, once): the binary does not need -mavx2 to use AVX2, and does not crash on a CPU without it. The SIMD
+// kernels are compiled for their instruction set with the target attribute (GCC / Clang on x86); elsewhere only the
+// scalar kernels exist.
+//
+// Differences with the plain loops:
+//   - Floating-point sum and dot add in a different order (one partial sum per lane and accumulator), so the
+//     result can differ in the last bits. It is usually closer to the exact sum, not further.
+//   - int32 sum and dot accumulate in 64 bits and return an int64, no overflow on large inputs.
+//   - min / max with NaNs in the input return an unspecified element.
+//
+//   Vector<float> prices = ...;
+//   float total = pysojic::simd::sum(prices);
+//   size_t pos = pysojic::simd::find(prices, 0.0f); // prices.size() if absent
+namespace pysojic::simd
+{
+    enum class Isa
+    {
+        Scalar,
+        Avx2,   // AVX2 + FMA
+        Avx512  // AVX-512F
+    };
+
+    // Instruction set the kernels run with on this CPU
+    Isa active_isa() noexcept;
+
+    template <typename T>
+    concept SimdElement = std::same_as<T, float> || std::same_as<T, double> || std::same_as<T, std::int32_t>;
+
+    template <SimdElement T>
+    using sum_type = std::conditional_t<std::is_integral_v<T>, std::int64_t, T>;
+
+    // Anything exposing its elements as one array through data() / size()
+    template <typename C>
+    concept ContiguousContainer = requires(const C& c) {
+        requires SimdElement<std::remove_cvref_t<decltype(*c.data())>>;
+        { c.size() } -> std::convertible_to<std::size_t>;
+    };
+
+    template <ContiguousContainer C>
+    using element_type = std::remove_cvref_t<decltype(*std::declval<const C&>().data())>;
+
+    template <SimdElement T>
+    sum_type<T> sum(std::span<const T> values) noexcept;
+    // Precondition: values is not empty
+    template <SimdElement T>
+    T min(std::span<const T> values) noexcept;
+    template <SimdElement T>
+    T max(std::span<const T> values) noexcept;
+    // Index of the first element equal to value, values.size() if there is none
+    template <SimdElement T>
+    std::size_t find(std::span<const T> values, T value) noexcept;
+    template <SimdElement T>
+    std::size_t count(std::span<const T> values, T value) noexcept;
+    // Precondition: a.size() == b.size()
+    template <SimdElement T>
+    sum_type<T> dot(std::span<const T> a, std::span<const T> b) noexcept;
+
+    template <ContiguousContainer C>
+    auto sum(const C& c) noexcept { return sum(std::span<const element_type<C>>(c.data(), c.size())); }
+    template <ContiguousContainer C>
+    auto min(const C& c) noexcept { return min(std::span<const element_type<C>>(c.data(), c.size())); }
+    template <ContiguousContainer C>
+    auto max(const C& c) noexcept { return max(std::span<const element_type<C>>(c.data(), c.size())); }
+    template <ContiguousContainer C>
+    std::size_t find(const C& c, element_type<C> value) noexcept
+    {
+        return find(std::span<const element_type<C>>(c.data(), c.size()), value);
+    }
+    template <ContiguousContainer C>
+    std::size_t count(const C& c, element_type<C> value) noexcept
+    {
+        return count(std::span<const element_type<C>>(c.data(), c.size()), value);
+    }
+    template <ContiguousContainer C>
+    auto dot(const C& a, const C& b) noexcept
+    {
+        return dot(std::span<const element_type<C>>(a.data(), a.size()), std::span<const element_type<C>>(b.data(), b.size()));
+    }
+}
+
+namespace pysojic::simd_detail
+{
+    using simd::sum_type;
+
+    // Reference kernels, also used for the tails shorter than a register
+    namespace scalar
+    {
+        template <typename T>
+        sum_type<T> sum(const T* p, std::size_t n) noexcept
+        {
+            sum_type<T> result{};
+            for (std::size_t i = 0; i < n; ++i)
+                result += p[i];
+            return result;
+        }
+
+        template <typename T>
+        T min(const T* p, std::size_t n) noexcept
+        {
+            T result = p[0];
+            for (std::size_t i = 1; i < n; ++i)
+                result = std::min(result, p[i]);
+            return result;
+        }
+
+        template <typename T>
+        T max(const T* p, std::size_t n) noexcept
+        {
+            T result = p[0];
+            for (std::size_t i = 1; i < n; ++i)
+                result = std::max(result, p[i]);
+            return result;
+        }
+
+        template <typename T>
+        std::size_t find(const T* p, std::size_t n, T value) noexcept
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                if (p[i] == value)
+                    return i;
+            }
+            return n;
+        }
+
+        template <typename T>
+        std::size_t count(const T* p, std::size_t n, T value) noexcept
+        {
+            std::size_t result = 0;
+            for (std::size_t i = 0; i < n; ++i)
+                result += p[i] == value;
+            return result;
+        }
+
+        template <typename T>
+        sum_type<T> dot(const T* a, const T* b, std::size_t n) noexcept
+        {
+            sum_type<T> result{};
+            for (std::size_t i = 0; i < n; ++i)
+                result += static_cast<sum_type<T>>(a[i]) * b[i];
+            return result;
+        }
+    }
+
+#if defined(PYSOJIC_SIMD_DISPATCH)
+    // Independent accumulators per reduction: an add / FMA has a latency of ~4 cycles but 2 can start per cycle,
+    // a single accumulator would leave the units idle most of the time
+    inline constexpr std::size_t UNROLL = 4;
+
+    // Per element type, the few register operations the kernels need. Everything is always_inline so that the
+    // kernels are still plain vector code at -O0.
+    // The kernels are written once per instruction set: a function only gets the instructions of its own target
+    // attribute, so the loops cannot be shared between the two (the Ops they call could not be inlined).
+    namespace avx2
+    {
+        template <typename T>
+        struct Ops;
+
+        template <>
+        struct Ops<float>
+        {
+            using Reg = __m256;
+            using Acc = __m256;
+            static constexpr std::size_t LANES = 8;
+
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg set1(float v) noexcept { return _mm256_set1_ps(v); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc zero() noexcept { return _mm256_setzero_ps(); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc add(Acc a, Acc b) noexcept { return _mm256_add_ps(a, b); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc accumulate(Acc acc, const float* p) noexcept
+            {
+                return _mm256_add_ps(acc, load(p));
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc accumulate_dot(Acc acc, const float* a, const float* b) noexcept
+            {
+                return _mm256_fmadd_ps(load(a), load(b), acc);
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static float reduce_add(Acc acc) noexcept
+            {
+                alignas(32) float lanes[LANES];
+                _mm256_store_ps(lanes, acc);
+                return scalar::sum(lanes, LANES);
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg min(Reg a, Reg b) noexcept { return _mm256_min_ps(a, b); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg max(Reg a, Reg b) noexcept { return _mm256_max_ps(a, b); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static float reduce_min(Reg r) noexcept
+            {
+                alignas(32) float lanes[LANES];
+                _mm256_store_ps(lanes, r);
+                return scalar::min(lanes, LANES);
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static float reduce_max(Reg r) noexcept
+            {
+                alignas(32) float lanes[LANES];
+                _mm256_store_ps(lanes, r);
+                return scalar::max(lanes, LANES);
+            }
+            // Bit i set when lane i of a equals lane i of b
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static std::uint32_t eq_mask(Reg a, Reg b) noexcept
+            {
+                return static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)));
+            }
+        };
+
+        template <>
+        struct Ops<double>
+        {
+            using Reg = __m256d;
+            using Acc = __m256d;
+            static constexpr std::size_t LANES = 4;
+
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg load(const double* p) noexcept { return _mm256_loadu_pd(p); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg set1(double v) noexcept { return _mm256_set1_pd(v); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc zero() noexcept { return _mm256_setzero_pd(); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc add(Acc a, Acc b) noexcept { return _mm256_add_pd(a, b); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc accumulate(Acc acc, const double* p) noexcept
+            {
+                return _mm256_add_pd(acc, load(p));
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc accumulate_dot(Acc acc, const double* a, const double* b) noexcept
+            {
+                return _mm256_fmadd_pd(load(a), load(b), acc);
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static double reduce_add(Acc acc) noexcept
+            {
+                alignas(32) double lanes[LANES];
+                _mm256_store_pd(lanes, acc);
+                return scalar::sum(lanes, LANES);
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg min(Reg a, Reg b) noexcept { return _mm256_min_pd(a, b); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg max(Reg a, Reg b) noexcept { return _mm256_max_pd(a, b); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static double reduce_min(Reg r) noexcept
+            {
+                alignas(32) double lanes[LANES];
+                _mm256_store_pd(lanes, r);
+                return scalar::min(lanes, LANES);
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static double reduce_max(Reg r) noexcept
+            {
+                alignas(32) double lanes[LANES];
+                _mm256_store_pd(lanes, r);
+                return scalar::max(lanes, LANES);
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static std::uint32_t eq_mask(Reg a, Reg b) noexcept
+            {
+                return static_cast<std::uint32_t>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)));
+            }
+        };
+
+        template <>
+        struct Ops<std::int32_t>
+        {
+            using Reg = __m256i;
+            // 4 x int64: each batch of 8 int32 is sign-extended in two halves
+            using Acc = __m256i;
+            static constexpr std::size_t LANES = 8;
+
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg load(const std::int32_t* p) noexcept
+            {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static __m256i load_widened(const std::int32_t* p) noexcept
+            {
+                return _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg set1(std::int32_t v) noexcept { return _mm256_set1_epi32(v); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc zero() noexcept { return _mm256_setzero_si256(); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc add(Acc a, Acc b) noexcept { return _mm256_add_epi64(a, b); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc accumulate(Acc acc, const std::int32_t* p) noexcept
+            {
+                acc = _mm256_add_epi64(acc, load_widened(p));
+                return _mm256_add_epi64(acc, load_widened(p + 4));
+            }
+            // _mm256_mul_epi32 multiplies the low (signed) 32 bits of each 64-bit lane into a 64-bit product
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Acc accumulate_dot(Acc acc, const std::int32_t* a, const std::int32_t* b) noexcept
+            {
+                acc = _mm256_add_epi64(acc, _mm256_mul_epi32(load_widened(a), load_widened(b)));
+                return _mm256_add_epi64(acc, _mm256_mul_epi32(load_widened(a + 4), load_widened(b + 4)));
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static std::int64_t reduce_add(Acc acc) noexcept
+            {
+                alignas(32) std::int64_t lanes[4];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+                return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg min(Reg a, Reg b) noexcept { return _mm256_min_epi32(a, b); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static Reg max(Reg a, Reg b) noexcept { return _mm256_max_epi32(a, b); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static std::int32_t reduce_min(Reg r) noexcept
+            {
+                alignas(32) std::int32_t lanes[LANES];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), r);
+                return scalar::min(lanes, LANES);
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static std::int32_t reduce_max(Reg r) noexcept
+            {
+                alignas(32) std::int32_t lanes[LANES];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), r);
+                return scalar::max(lanes, LANES);
+            }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static std::uint32_t eq_mask(Reg a, Reg b) noexcept
+            {
+                return static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b))));
+            }
+        };
+
+        template <typename T>
+        [[gnu::target("avx2,fma")]] sum_type<T> sum(const T* p, std::size_t n) noexcept
+        {
+            using O = Ops<T>;
+            typename O::Acc acc[UNROLL];
+            for (auto& a : acc)
+                a = O::zero();
+
+            std::size_t i = 0;
+            for (; i + UNROLL * O::LANES <= n; i += UNROLL * O::LANES)
+            {
+                for (std::size_t u = 0; u < UNROLL; ++u)
+                    acc[u] = O::accumulate(acc[u], p + i + u * O::LANES);
+            }
+            for (; i + O::LANES <= n; i += O::LANES)
+                acc[0] = O::accumulate(acc[0], p + i);
+
+            auto result = O::reduce_add(O::add(O::add(acc[0], acc[1]), O::add(acc[2], acc[3])));
+            return result + scalar::sum(p + i, n - i);
+        }
+
+        template <typename T>
+        [[gnu::target("avx2,fma")]] T min(const T* p, std::size_t n) noexcept
+        {
+            using O = Ops<T>;
+            if (n < O::LANES)
+                return scalar::min(p, n);
+
+            typename O::Reg m = O::load(p);
+            std::size_t i = O::LANES;
+            for (; i + O::LANES <= n; i += O::LANES)
+                m = O::min(m, O::load(p + i));
+            // Last (partial) register: reload the last LANES elements, seeing some of them twice does not change a min
+            m = O::min(m, O::load(p + n - O::LANES));
+            return O::reduce_min(m);
+        }
+
+        template <typename T>
+        [[gnu::target("avx2,fma")]] T max(const T* p, std::size_t n) noexcept
+        {
+            using O = Ops<T>;
+            if (n < O::LANES)
+                return scalar::max(p, n);
+
+            typename O::Reg m = O::load(p);
+            std::size_t i = O::LANES;
+            for (; i + O::LANES <= n; i += O::LANES)
+                m = O::max(m, O::load(p + i));
+            m = O::max(m, O::load(p + n - O::LANES));
+            return O::reduce_max(m);
+        }
+
+        template <typename T>
+        [[gnu::target("avx2,fma")]] std::size_t find(const T* p, std::size_t n, T value) noexcept
+        {
+            using O = Ops<T>;
+            typename O::Reg needle = O::set1(value);
+
+            std::size_t i = 0;
+            for (; i + UNROLL * O::LANES <= n; i += UNROLL * O::LANES)
+            {
+                // One branch per UNROLL registers, the exact position is only worked out once there is a match
+                std::uint64_t bits = 0;
+                for (std::size_t u = 0; u < UNROLL; ++u)
+                    bits |= std::uint64_t{O::eq_mask(O::load(p + i + u * O::LANES), needle)} << (u * O::LANES);
+                if (bits != 0)
+                    return i + static_cast<std::size_t>(std::countr_zero(bits));
+            }
+            for (; i + O::LANES <= n; i += O::LANES)
+            {
+                if (std::uint32_t bits = O::eq_mask(O::load(p + i), needle); bits != 0)
+                    return i + static_cast<std::size_t>(std::countr_zero(bits));
+            }
+            return i + scalar::find(p + i, n - i, value);
+        }
+
+        template <typename T>
+        [[gnu::target("avx2,fma")]] std::size_t count(const T* p, std::size_t n, T value) noexcept
+        {
+            using O = Ops<T>;
+            typename O::Reg needle = O::set1(value);
+
+            std::size_t result = 0;
+            std::size_t i = 0;
+            for (; i + O::LANES <= n; i += O::LANES)
+                result += static_cast<std::size_t>(std::popcount(O::eq_mask(O::load(p + i), needle)));
+            return result + scalar::count(p + i, n - i, value);
+        }
+
+        template <typename T>
+        [[gnu::target("avx2,fma")]] sum_type<T> dot(const T* a, const T* b, std::size_t n) noexcept
+        {
+            using O = Ops<T>;
+            typename O::Acc acc[UNROLL];
+            for (auto& x : acc)
+                x = O::zero();
+
+            std::size_t i = 0;
+            for (; i + UNROLL * O::LANES <= n; i += UNROLL * O::LANES)
+            {
+                for (std::size_t u = 0; u < UNROLL; ++u)
+                    acc[u] = O::accumulate_dot(acc[u], a + i + u * O::LANES, b + i + u * O::LANES);
+            }
+            for (; i + O::LANES <= n; i += O::LANES)
+                acc[0] = O::accumulate_dot(acc[0], a + i, b + i);
+
+            auto result = O::reduce_add(O::add(O::add(acc[0], acc[1]), O::add(acc[2], acc[3])));
+            return result + scalar::dot(a + i, b + i, n - i);
+        }
+    }
+
+    // Same operations on 512-bit registers, AVX-512 compares produce a mask register directly.
+    // Several GCC 12 intrinsics (_mm512_min/max/mul_epi32/cvtepi32_epi64/reduce_*) start from an undefined
+    // register and trigger -Wmaybe-uninitialized at -O2: the zero-masking forms with every lane selected are used
+    // instead (same instructions), and the horizontal reductions go through memory as for AVX2 (once per call).
+    // On some Intel server CPUs (Skylake-SP / Cascade Lake) heavy 512-bit code lowers the core clock for a while:
+    // short calls between scalar code may gain less than the width suggests.
+    namespace avx512
+    {
+        template <typename T>
+        struct Ops;
+
+        template <>
+        struct Ops<float>
+        {
+            using Reg = __m512;
+            using Acc = __m512;
+            static constexpr std::size_t LANES = 16;
+
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg load(const float* p) noexcept { return _mm512_loadu_ps(p); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg set1(float v) noexcept { return _mm512_set1_ps(v); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc zero() noexcept { return _mm512_setzero_ps(); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc add(Acc a, Acc b) noexcept { return _mm512_add_ps(a, b); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc accumulate(Acc acc, const float* p) noexcept
+            {
+                return _mm512_add_ps(acc, load(p));
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc accumulate_dot(Acc acc, const float* a, const float* b) noexcept
+            {
+                return _mm512_fmadd_ps(load(a), load(b), acc);
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static float reduce_add(Acc acc) noexcept
+            {
+                alignas(64) float lanes[LANES];
+                _mm512_store_ps(lanes, acc);
+                return scalar::sum(lanes, LANES);
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg min(Reg a, Reg b) noexcept { return _mm512_maskz_min_ps(__mmask16(~0u), a, b); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg max(Reg a, Reg b) noexcept { return _mm512_maskz_max_ps(__mmask16(~0u), a, b); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static float reduce_min(Reg r) noexcept
+            {
+                alignas(64) float lanes[LANES];
+                _mm512_store_ps(lanes, r);
+                return scalar::min(lanes, LANES);
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static float reduce_max(Reg r) noexcept
+            {
+                alignas(64) float lanes[LANES];
+                _mm512_store_ps(lanes, r);
+                return scalar::max(lanes, LANES);
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static std::uint32_t eq_mask(Reg a, Reg b) noexcept
+            {
+                return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ);
+            }
+        };
+
+        template <>
+        struct Ops<double>
+        {
+            using Reg = __m512d;
+            using Acc = __m512d;
+            static constexpr std::size_t LANES = 8;
+
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg load(const double* p) noexcept { return _mm512_loadu_pd(p); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg set1(double v) noexcept { return _mm512_set1_pd(v); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc zero() noexcept { return _mm512_setzero_pd(); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc add(Acc a, Acc b) noexcept { return _mm512_add_pd(a, b); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc accumulate(Acc acc, const double* p) noexcept
+            {
+                return _mm512_add_pd(acc, load(p));
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc accumulate_dot(Acc acc, const double* a, const double* b) noexcept
+            {
+                return _mm512_fmadd_pd(load(a), load(b), acc);
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static double reduce_add(Acc acc) noexcept
+            {
+                alignas(64) double lanes[LANES];
+                _mm512_store_pd(lanes, acc);
+                return scalar::sum(lanes, LANES);
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg min(Reg a, Reg b) noexcept { return _mm512_maskz_min_pd(__mmask8(~0u), a, b); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg max(Reg a, Reg b) noexcept { return _mm512_maskz_max_pd(__mmask8(~0u), a, b); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static double reduce_min(Reg r) noexcept
+            {
+                alignas(64) double lanes[LANES];
+                _mm512_store_pd(lanes, r);
+                return scalar::min(lanes, LANES);
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static double reduce_max(Reg r) noexcept
+            {
+                alignas(64) double lanes[LANES];
+                _mm512_store_pd(lanes, r);
+                return scalar::max(lanes, LANES);
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static std::uint32_t eq_mask(Reg a, Reg b) noexcept
+            {
+                return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ);
+            }
+        };
+
+        template <>
+        struct Ops<std::int32_t>
+        {
+            using Reg = __m512i;
+            // 8 x int64, see avx2::Ops<std::int32_t>
+            using Acc = __m512i;
+            static constexpr std::size_t LANES = 16;
+
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg load(const std::int32_t* p) noexcept
+            {
+                return _mm512_loadu_si512(p);
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static __m512i load_widened(const std::int32_t* p) noexcept
+            {
+                return _mm512_maskz_cvtepi32_epi64(__mmask8(~0u), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg set1(std::int32_t v) noexcept { return _mm512_set1_epi32(v); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc zero() noexcept { return _mm512_setzero_si512(); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc add(Acc a, Acc b) noexcept { return _mm512_add_epi64(a, b); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc accumulate(Acc acc, const std::int32_t* p) noexcept
+            {
+                acc = _mm512_add_epi64(acc, load_widened(p));
+                return _mm512_add_epi64(acc, load_widened(p + 8));
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Acc accumulate_dot(Acc acc, const std::int32_t* a, const std::int32_t* b) noexcept
+            {
+                acc = _mm512_add_epi64(acc, _mm512_maskz_mul_epi32(__mmask8(~0u), load_widened(a), load_widened(b)));
+                return _mm512_add_epi64(acc, _mm512_maskz_mul_epi32(__mmask8(~0u), load_widened(a + 8), load_widened(b + 8)));
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static std::int64_t reduce_add(Acc acc) noexcept
+            {
+                alignas(64) std::int64_t lanes[8];
+                _mm512_store_si512(lanes, acc);
+                std::int64_t result = 0;
+                for (std::int64_t lane : lanes)
+                    result += lane;
+                return result;
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg min(Reg a, Reg b) noexcept { return _mm512_maskz_min_epi32(__mmask16(~0u), a, b); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static Reg max(Reg a, Reg b) noexcept { return _mm512_maskz_max_epi32(__mmask16(~0u), a, b); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static std::int32_t reduce_min(Reg r) noexcept
+            {
+                alignas(64) std::int32_t lanes[LANES];
+                _mm512_store_si512(lanes, r);
+                return scalar::min(lanes, LANES);
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static std::int32_t reduce_max(Reg r) noexcept
+            {
+                alignas(64) std::int32_t lanes[LANES];
+                _mm512_store_si512(lanes, r);
+                return scalar::max(lanes, LANES);
+            }
+            [[gnu::target("avx512f"), gnu::always_inline]] static std::uint32_t eq_mask(Reg a, Reg b) noexcept
+            {
+                return _mm512_cmpeq_epi32_mask(a, b);
+            }
+        };
+
+        template <typename T>
+        [[gnu::target("avx512f")]] sum_type<T> sum(const T* p, std::size_t n) noexcept
+        {
+            using O = Ops<T>;
+            typename O::Acc acc[UNROLL];
+            for (auto& a : acc)
+                a = O::zero();
+
+            std::size_t i = 0;
+            for (; i + UNROLL * O::LANES <= n; i += UNROLL * O::LANES)
+            {
+                for (std::size_t u = 0; u < UNROLL; ++u)
+                    acc[u] = O::accumulate(acc[u], p + i + u * O::LANES);
+            }
+            for (; i + O::LANES <= n; i += O::LANES)
+                acc[0] = O::accumulate(acc[0], p + i);
+
+            auto result = O::reduce_add(O::add(O::add(acc[0], acc[1]), O::add(acc[2], acc[3])));
+            return result + scalar::sum(p + i, n - i);
+        }
+
+        template <typename T>
+        [[gnu::target("avx512f")]] T min(const T* p, std::size_t n) noexcept
+        {
+            using O = Ops<T>;
+            if (n < O::LANES)
+                return scalar::min(p, n);
+
+            typename O::Reg m = O::load(p);
+            std::size_t i = O::LANES;
+            for (; i + O::LANES <= n; i += O::LANES)
+                m = O::min(m, O::load(p + i));
+            m = O::min(m, O::load(p + n - O::LANES));
+            return O::reduce_min(m);
+        }
+
+        template <typename T>
+        [[gnu::target("avx512f")]] T max(const T* p, std::size_t n) noexcept
+        {
+            using O = Ops<T>;
+            if (n < O::LANES)
+                return scalar::max(p, n);
+
+            typename O::Reg m = O::load(p);
+            std::size_t i = O::LANES;
+            for (; i + O::LANES <= n; i += O::LANES)
+                m = O::max(m, O::load(p + i));
+            m = O::max(m, O::load(p + n - O::LANES));
+            return O::reduce_max(m);
+        }
+
+        template <typename T>
+        [[gnu::target("avx512f")]] std::size_t find(const T* p, std::size_t n, T value) noexcept
+        {
+            using O = Ops<T>;
+            typename O::Reg needle = O::set1(value);
+
+            std::size_t i = 0;
+            for (; i + UNROLL * O::LANES <= n; i += UNROLL * O::LANES)
+            {
+                std::uint64_t bits = 0;
+                for (std::size_t u = 0; u < UNROLL; ++u)
+                    bits |= std::uint64_t{O::eq_mask(O::load(p + i + u * O::LANES), needle)} << (u * O::LANES);
+                if (bits != 0)
+                    return i + static_cast<std::size_t>(std::countr_zero(bits));
+            }
+            for (; i + O::LANES <= n; i += O::LANES)
+            {
+                if (std::uint32_t bits = O::eq_mask(O::load(p + i), needle); bits != 0)
+                    return i + static_cast<std::size_t>(std::countr_zero(bits));
+            }
+            return i + scalar::find(p + i, n - i, value);
+        }
+
+        template <typename T>
+        [[gnu::target("avx512f")]] std::size_t count(const T* p, std::size_t n, T value) noexcept
+        {
+            using O = Ops<T>;
+            typename O::Reg needle = O::set1(value);
+
+            std::size_t result = 0;
+            std::size_t i = 0;
+            for (; i + O::LANES <= n; i += O::LANES)
+                result += static_cast<std::size_t>(std::popcount(O::eq_mask(O::load(p + i), needle)));
+            return result + scalar::count(p + i, n - i, value);
+        }
+
+        template <typename T>
+        [[gnu::target("avx512f")]] sum_type<T> dot(const T* a, const T* b, std::size_t n) noexcept
+        {
+            using O = Ops<T>;
+            typename O::Acc acc[UNROLL];
+            for (auto& x : acc)
+                x = O::zero();
+
+            std::size_t i = 0;
+            for (; i + UNROLL * O::LANES <= n; i += UNROLL * O::LANES)
+            {
+                for (std::size_t u = 0; u < UNROLL; ++u)
+                    acc[u] = O::accumulate_dot(acc[u], a + i + u * O::LANES, b + i + u * O::LANES);
+            }
+            for (; i + O::LANES <= n; i += O::LANES)
+                acc[0] = O::accumulate_dot(acc[0], a + i, b + i);
+
+            auto result = O::reduce_add(O::add(O::add(acc[0], acc[1]), O::add(acc[2], acc[3])));
+            return result + scalar::dot(a + i, b + i, n - i);
+        }
+    }
+#endif
+
+    inline simd::Isa detect_isa() noexcept
+    {
+#if defined(PYSOJIC_SIMD_DISPATCH)
+        // (also checks that the OS saves the wider registers on context switches)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return simd::Isa::Avx512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return simd::Isa::Avx2;
+#endif
+        return simd::Isa::Scalar;
+    }
+}
+
+//------------ Implementation ------------
+
+namespace pysojic::simd
+{
+    inline Isa active_isa() noexcept
+    {
+        static const Isa isa = simd_detail::detect_isa();
+        return isa;
+    }
+
+    // Dispatch: the switch is on a value that never changes, the branch is always predicted
+
+    template <SimdElement T>
+    sum_type<T> sum(std::span<const T> values) noexcept
+    {
+        switch (active_isa())
+        {
+#if defined(PYSOJIC_SIMD_DISPATCH)
+        case Isa::Avx512: return simd_detail::avx512::sum(values.data(), values.size());
+        case Isa::Avx2: return simd_detail::avx2::sum(values.data(), values.size());
+#endif
+        default: return simd_detail::scalar::sum(values.data(), values.size());
+        }
+    }
+
+    template <SimdElement T>
+    T min(std::span<const T> values) noexcept
+    {
+        assert(!values.empty());
+        switch (active_isa())
+        {
+#if defined(PYSOJIC_SIMD_DISPATCH)
+        case Isa::Avx512: return simd_detail::avx512::min(values.data(), values.size());
+        case Isa::Avx2: return simd_detail::avx2::min(values.data(), values.size());
+#endif
+        default: return simd_detail::scalar::min(values.data(), values.size());
+        }
+    }
+
+    template <SimdElement T>
+    T max(std::span<const T> values) noexcept
+    {
+        assert(!values.empty());
+        switch (active_isa())
+        {
+#if defined(PYSOJIC_SIMD_DISPATCH)
+        case Isa::Avx512: return simd_detail::avx512::max(values.data(), values.size());
+        case Isa::Avx2: return simd_detail::avx2::max(values.data(), values.size());
+#endif
+        default: return simd_detail::scalar::max(values.data(), values.size());
+        }
+    }
+
+    template <SimdElement T>
+    std::size_t find(std::span<const T> values, T value) noexcept
+    {
+        switch (active_isa())
+        {
+#if defined(PYSOJIC_SIMD_DISPATCH)
+        case Isa::Avx512: return simd_detail::avx512::find(values.data(), values.size(), value);
+        case Isa::Avx2: return simd_detail::avx2::find(values.data(), values.size(), value);
+#endif
+        default: return simd_detail::scalar::find(values.data(), values.size(), value);
+        }
+    }
+
+    template <SimdElement T>
+    std::size_t count(std::span<const T> values, T value) noexcept
+    {
+        switch (active_isa())
+        {
+#if defined(PYSOJIC_SIMD_DISPATCH)
+        case Isa::Avx512: return simd_detail::avx512::count(values.data(), values.size(), value);
+        case Isa::Avx2: return simd_detail::avx2::count(values.data(), values.size(), value);
+#endif
+        default: return simd_detail::scalar::count(values.data(), values.size(), value);
+        }
+    }
+
+    template <SimdElement T>
+    sum_type<T> dot(std::span<const T> a, std::span<const T> b) noexcept
+    {
+        assert(a.size() == b.size());
+        switch (active_isa())
+        {
+#if defined(PYSOJIC_SIMD_DISPATCH)
+        case Isa::Avx512: return simd_detail::avx512::dot(a.data(), b.data(), a.size());
+        case Isa::Avx2: return simd_detail::avx2::dot(a.data(), b.data(), a.size());
+#endif
+        default: return simd_detail::scalar::dot(a.data(), b.data(), a.size());
+        }
+    }
+}
+
+#undef PYSOJIC_SIMD_DISPATCH
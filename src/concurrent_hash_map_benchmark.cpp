@@ -0,0 +1,105 @@
+// Throughput of ConcurrentHashMap with each shard lock, from 1 to 32 threads: the plain test-and-set spinlock SpinLock
+// used to be (every waiter hammers the line with RMWs and never yields), the current TTAS SpinLock, Mutex and
+// std::mutex. 64 shards is the default; 4 shards puts several threads on every lock.
+// Mixed workload: 80% find, 20% insert_or_assign, on 64K keys.
+//   g++ -std=c++23 -O2 -march=native -pthread -Iinclude src/concurrent_hash_map_benchmark.cpp -o concurrent_hash_map_benchmark
+// With more threads than cores, a spinning waiter can burn the time slice the lock owner needs to release the lock:
+// this is where a lock that never yields collapses.
+
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Concurrency/Mutex.hpp"
+#include "Concurrency/SpinLock.hpp"
+#include "Containers/ConcurrentHashMap.hpp"
+
+namespace
+{
+    // SpinLock as it was: test_and_set in a tight loop
+    class TASLock
+    {
+    public:
+        void lock() noexcept
+        {
+            while (m_Flag.test_and_set(std::memory_order_acquire))
+            {
+            }
+        }
+        void unlock() noexcept { m_Flag.clear(std::memory_order_release); }
+
+    private:
+        std::atomic_flag m_Flag = ATOMIC_FLAG_INIT;
+    };
+
+    constexpr std::uint64_t KEYS = 1 << 16;
+    constexpr int OPS_PER_THREAD = 200'000;
+
+    // Millions of operations per second, all threads together
+    template <typename Lock, size_t Shards>
+    double run(int threads)
+    {
+        pysojic::ConcurrentHashMap<std::uint64_t, std::uint64_t, std::hash<std::uint64_t>, std::equal_to<std::uint64_t>,
+                                   Lock, Shards> map;
+        for (std::uint64_t k = 0; k < KEYS; k += 2)
+            map.insert(k, k);
+
+        std::barrier start(threads + 1);
+        std::atomic<std::uint64_t> sink{0};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]
+            {
+                std::uint64_t x = 0x9E3779B97F4A7C15ull * (t + 1); // xorshift state
+                std::uint64_t found = 0;
+                start.arrive_and_wait();
+                for (int i = 0; i < OPS_PER_THREAD; ++i)
+                {
+                    x ^= x << 13;
+                    x ^= x >> 7;
+                    x ^= x << 17;
+                    std::uint64_t key = x & (KEYS - 1);
+                    if ((x >> 32) % 5 == 0)
+                        map.insert_or_assign(key, x);
+                    else
+                        found += map.contains(key);
+                }
+                sink.fetch_add(found, std::memory_order_relaxed);
+            });
+        }
+
+        start.arrive_and_wait();
+        auto begin = std::chrono::steady_clock::now();
+        for (auto& w : workers)
+            w.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return static_cast<double>(OPS_PER_THREAD) * threads / seconds / 1e6;
+    }
+
+    template <size_t Shards>
+    void table()
+    {
+        std::printf("%zu shards (Mops/s)  TAS spin  SpinLock     Mutex  std::mutex\n", Shards);
+        for (int threads : {1, 2, 4, 8, 16, 32})
+        {
+            std::printf("  %2d threads %15.1f %9.1f %9.1f %11.1f\n", threads,
+                        run<TASLock, Shards>(threads),
+                        run<SpinLock, Shards>(threads),
+                        run<Mutex, Shards>(threads),
+                        run<std::mutex, Shards>(threads));
+        }
+    }
+}
+
+int main()
+{
+    std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+    table<64>();
+    table<4>();
+}
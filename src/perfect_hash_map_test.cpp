@@ -0,0 +1,67 @@
+// PerfectHashMap checks: the static_asserts run when this file compiles, the rest at runtime.
+//   g++ -std=c++23 -Wall -Wextra -Iinclude src/perfect_hash_map_test.cpp -o perfect_hash_map_test
+
+#include <array>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "Utilities/CompileTimeFunctions.hpp"
+#include "Containers/PerfectHashMap.hpp"
+
+namespace
+{
+    enum class Side { Buy, Sell, Short };
+
+    constexpr pysojic::PerfectHashMap codes{std::array{std::pair{'A', 1}, std::pair{'D', 2}, std::pair{'X', 3}}};
+    static_assert(codes.at('D') == 2 && codes['X'] == 3 && !codes.contains('B') && codes.size() == 3);
+
+    constexpr pysojic::PerfectHashMap<std::string_view, int, 3> messages{{{{"NEW", 1}, {"CANCEL", 2}, {"FILL", 3}}}};
+    static_assert(messages.at("CANCEL") == 2 && !messages.contains("REPLACE"));
+
+    constexpr auto ports = pysojic::make_perfect_hash_map(CompileTimeVector<80, 443, 8080>{}, std::array{1, 2, 3});
+    static_assert(ports[443] == 2 && ports.find(22) == nullptr);
+
+    constexpr pysojic::PerfectHashMap sides{std::array{std::pair{Side::Buy, 'B'}, std::pair{Side::Sell, 'S'}}};
+    static_assert(sides.at(Side::Sell) == 'S' && !sides.contains(Side::Short));
+
+    // Enough keys for several buckets per pilot search
+    constexpr auto squares = []
+    {
+        std::array<std::pair<int, int>, 200> entries{};
+        for (int i = 0; i < 200; ++i)
+            entries[i] = {i * 7919, i * i};
+        return pysojic::PerfectHashMap{entries};
+    }();
+    static_assert(squares.at(150 * 7919) == 150 * 150 && !squares.contains(1));
+}
+
+int main()
+{
+    // Every key is found at runtime too, and nothing else is
+    for (int i = 0; i < 200; ++i)
+    {
+        assert(squares.at(i * 7919) == i * i);
+        assert(!squares.contains(i * 7919 + 1));
+    }
+
+    // Transparent lookup from other string types
+    std::string fill = "FILL";
+    assert(messages.at(fill.c_str()) == 3 && messages.contains(fill));
+
+    bool thrown = false;
+    try
+    {
+        (void)messages.at("REPLACE");
+    }
+    catch (const std::out_of_range&)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::cout << "PerfectHashMap: ok\n";
+}
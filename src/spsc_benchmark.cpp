@@ -0,0 +1,92 @@
+// Throughput of SPSCQueue between two threads, compared with the same queue without the cached indices
+// (every push reloads the read index and every pop the write index).
+// Build with optimizations and run on a machine with at least two cores, e.g.
+//   g++ -std=c++23 -O2 -march=native -pthread -Iinclude src/spsc_benchmark.cpp -o spsc_benchmark
+// Pin the threads to two distinct physical cores (taskset -c 2,4 ./spsc_benchmark) for stable numbers.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include "Containers/SPSCQueue.hpp"
+
+namespace
+{
+    // Baseline: same layout and algorithm, but both indices are read from the shared line on every operation
+    template <typename T, std::size_t Capacity>
+    class UncachedSPSCQueue
+    {
+    public:
+        bool push(const T& value) noexcept
+        {
+            auto w = m_WriteIdx.load(std::memory_order_relaxed);
+            if (w - m_ReadIdx.load(std::memory_order_acquire) == Capacity)
+                return false;
+            m_Data[w & (Capacity - 1)] = value;
+            m_WriteIdx.store(w + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T& out) noexcept
+        {
+            auto r = m_ReadIdx.load(std::memory_order_relaxed);
+            if (r == m_WriteIdx.load(std::memory_order_acquire))
+                return false;
+            out = m_Data[r & (Capacity - 1)];
+            m_ReadIdx.store(r + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        alignas(64) std::array<T, Capacity> m_Data;
+        alignas(64) std::atomic<std::size_t> m_ReadIdx{0};
+        alignas(64) std::atomic<std::size_t> m_WriteIdx{0};
+    };
+
+    constexpr std::size_t CAPACITY = 1024;
+    constexpr std::uint64_t ITEMS = 50'000'000;
+
+    // Returns millions of elements per second
+    template <typename Queue>
+    double run()
+    {
+        auto queue = std::make_unique<Queue>();
+        std::uint64_t sum = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        std::thread consumer([&]
+        {
+            std::uint64_t value;
+            for (std::uint64_t i = 0; i < ITEMS; ++i)
+            {
+                while (!queue->pop(value))
+                    ;
+                sum += value;
+            }
+        });
+        for (std::uint64_t i = 0; i < ITEMS; ++i)
+        {
+            while (!queue->push(i))
+                ;
+        }
+        consumer.join();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (sum != ITEMS * (ITEMS - 1) / 2)
+            std::printf("wrong sum!\n");
+        return ITEMS / elapsed.count() / 1e6;
+    }
+}
+
+int main()
+{
+    for (int rep = 0; rep < 3; ++rep)
+    {
+        std::printf("uncached indices: %7.1f M elements/s\n", run<UncachedSPSCQueue<std::uint64_t, CAPACITY>>());
+        std::printf("cached indices:   %7.1f M elements/s\n", run<SPSCQueue<std::uint64_t, CAPACITY>>());
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Exception safety of Vector: an element constructor that throws must leave the Vector as it was, with every
+// object built by the Vector destroyed exactly once. Standalone, build it with sanitizers:
+//   g++ -std=c++23 -g -fsanitize=address,undefined -Iinclude src/vector_test.cpp -o vector_test
+
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <stdexcept>
+
+#include "Containers/Vector.hpp"
+
+namespace
+{
+    // Counts the live instances, and throws from the copy constructor once the budget of copies is spent
+    struct ThrowingCopy
+    {
+        static inline int live = 0;
+        static inline int copyBudget = -1; // < 0: unlimited
+
+        int value;
+
+        ThrowingCopy(int v) : value{v} { ++live; }
+        ThrowingCopy(const ThrowingCopy& other) : value{other.value}
+        {
+            if (copyBudget == 0)
+                throw std::runtime_error("copy failed");
+            if (copyBudget > 0)
+                --copyBudget;
+            ++live;
+        }
+        ThrowingCopy(ThrowingCopy&& other) noexcept : value{other.value} { ++live; }
+        ThrowingCopy& operator=(const ThrowingCopy&) = default;
+        ThrowingCopy& operator=(ThrowingCopy&&) noexcept = default;
+        ~ThrowingCopy() { --live; }
+    };
+
+    // Single pass over a list, to go through the insertion path that does not know the count up front
+    struct InputOnly
+    {
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = ThrowingCopy;
+        using difference_type = std::ptrdiff_t;
+
+        std::list<ThrowingCopy>::const_iterator it;
+
+        const ThrowingCopy& operator*() const { return *it; }
+        InputOnly& operator++() { ++it; return *this; }
+        void operator++(int) { ++it; }
+        bool operator==(const InputOnly&) const = default;
+    };
+    static_assert(std::input_iterator<InputOnly> && !std::forward_iterator<InputOnly>);
+
+    template <typename F>
+    void expect_throw(F&& f)
+    {
+        bool thrown = false;
+        try
+        {
+            f();
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        ThrowingCopy::copyBudget = -1;
+        assert(thrown);
+    }
+
+    template <typename V>
+    void expect_values(const V& v, std::initializer_list<int> values)
+    {
+        assert(v.size() == values.size());
+        size_t i = 0;
+        for (int value : values)
+            assert(v[i++].value == value);
+    }
+
+    template <typename V>
+    void test_push_and_emplace()
+    {
+        V v;
+        v.emplace_back(1);
+        v.emplace_back(2);
+        ThrowingCopy three{3};
+
+        ThrowingCopy::copyBudget = 0;
+        expect_throw([&] { v.push_back(three); });
+        expect_values(v, {1, 2});
+
+        ThrowingCopy::copyBudget = 0;
+        expect_throw([&] { v.emplace_back(three); });
+        expect_values(v, {1, 2});
+
+        v.push_back(three);
+        expect_values(v, {1, 2, 3});
+    }
+
+    template <typename V>
+    void test_insert_range()
+    {
+        V v;
+        for (int i = 0; i < 4; ++i)
+            v.emplace_back(i);
+
+        // Forward range: one reallocation, then the third copy throws
+        std::list<ThrowingCopy> list{ThrowingCopy{10}, ThrowingCopy{11}, ThrowingCopy{12}, ThrowingCopy{13}};
+        int liveBefore = ThrowingCopy::live;
+        ThrowingCopy::copyBudget = 2;
+        expect_throw([&] { v.insert_range(1, list); });
+        assert(ThrowingCopy::live == liveBefore);
+        expect_values(v, {0, 1, 2, 3});
+
+        // Single pass: element by element through emplace_back, growing on the way
+        std::list<ThrowingCopy> more{ThrowingCopy{20}, ThrowingCopy{21}, ThrowingCopy{22}};
+        liveBefore = ThrowingCopy::live;
+        ThrowingCopy::copyBudget = 1;
+        expect_throw([&] { v.append(InputOnly{more.cbegin()}, InputOnly{more.cend()}); });
+        assert(ThrowingCopy::live == liveBefore);
+        expect_values(v, {0, 1, 2, 3});
+
+        v.insert_range(1, list);
+        expect_values(v, {0, 10, 11, 12, 13, 1, 2, 3});
+    }
+
+    template <typename V>
+    void test_copy()
+    {
+        V v;
+        for (int i = 0; i < 5; ++i)
+            v.emplace_back(i);
+        int liveBefore = ThrowingCopy::live;
+
+        ThrowingCopy::copyBudget = 3;
+        expect_throw([&] { V copy(v); });
+        assert(ThrowingCopy::live == liveBefore);
+
+        ThrowingCopy::copyBudget = 0;
+        expect_throw([&] { V filled(4, v[0]); });
+        assert(ThrowingCopy::live == liveBefore);
+    }
+
+    template <typename V>
+    void run(const char* name)
+    {
+        test_push_and_emplace<V>();
+        test_insert_range<V>();
+        test_copy<V>();
+        assert(ThrowingCopy::live == 0);
+        std::cout << name << ": ok\n";
+    }
+}
+
+int main()
+{
+    run<Vector<ThrowingCopy>>("Vector");
+    run<SmallVector<ThrowingCopy, 4>>("SmallVector");
+}